@@ -0,0 +1,262 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "build_events.h"
+
+#include <nlohmann/json.hpp>
+#include <primitives/exceptions.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <primitives/log.h>
+DECLARE_STATIC_LOGGER(logger, "command");
+
+#define SW_BUILD_EVENTS_FILE ".sw/misc/events.jsonl"
+
+//
+bool write_build_events;
+
+namespace sw
+{
+
+namespace
+{
+
+struct ConsoleConsumer : BuildEventConsumer
+{
+    void onEvent(const BuildEvent &e) override
+    {
+        // start lines and outputs go through the same logger to keep order
+        if (e.type == BuildEvent::Start || e.type == BuildEvent::Output)
+            LOG_INFO(logger, e.text);
+    }
+};
+
+struct JsonLinesConsumer : BuildEventConsumer
+{
+    std::ofstream o;
+    BuildEvent::Clock::time_point start = BuildEvent::Clock::now();
+
+    JsonLinesConsumer(const path &fn)
+    {
+        fs::create_directories(fn.parent_path());
+        o.open(fn);
+    }
+
+    void onEvent(const BuildEvent &e) override
+    {
+        static const char *types[] = { "start", "finish", "outdated", "output" };
+
+        nlohmann::json j;
+        j["type"] = types[e.type];
+        j["time"] = std::chrono::duration_cast<std::chrono::microseconds>(e.time - start).count();
+        std::ostringstream ss;
+        ss << e.tid;
+        j["tid"] = ss.str();
+        j["name"] = e.name;
+        switch (e.type)
+        {
+        case BuildEvent::Start:
+            j["index"] = e.index;
+            j["total"] = e.total;
+            break;
+        case BuildEvent::Finish:
+            j["success"] = e.success;
+            break;
+        case BuildEvent::Outdated:
+            j["subject"] = e.subject;
+            j["reason"] = e.text;
+            break;
+        case BuildEvent::Output:
+            j["text"] = e.text;
+            break;
+        }
+        o << j.dump() << "\n";
+    }
+
+    void flush() override
+    {
+        o.flush();
+    }
+};
+
+}
+
+BuildEvents::BuildEvents(size_t ring_size)
+{
+    if (ring_size == 0 || (ring_size & (ring_size - 1)) != 0)
+        throw SW_RUNTIME_ERROR("Ring size must be a power of 2");
+    slots = std::make_unique<Slot[]>(ring_size);
+    for (size_t i = 0; i < ring_size; i++)
+        slots[i].seq = i;
+    mask = ring_size - 1;
+}
+
+BuildEvents::~BuildEvents()
+{
+    stop();
+}
+
+void BuildEvents::start()
+{
+    std::call_once(started, [this]
+    {
+        t = std::thread([this] { run(); });
+    });
+}
+
+void BuildEvents::push(BuildEvent &&e)
+{
+    if (closed)
+        return;
+    start();
+
+    // bounded mpmc queue by Dmitry Vyukov, we have a single consumer
+    auto pos = head.load(std::memory_order_relaxed);
+    Slot *s;
+    while (1)
+    {
+        s = &slots[pos & mask];
+        auto seq = s->seq.load(std::memory_order_acquire);
+        auto diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // full, wait for consumer
+            std::this_thread::yield();
+            pos = head.load(std::memory_order_relaxed);
+        }
+        else
+            pos = head.load(std::memory_order_relaxed);
+    }
+    s->e = std::move(e);
+    // seq_cst, see notify()
+    s->seq.store(pos + 1);
+    notify();
+}
+
+void BuildEvents::notify()
+{
+    // event is published and 'sleeping' is read with seq_cst, as well as consumer
+    // sets 'sleeping' and reads the event in ready(): one of them sees the other
+    if (!sleeping)
+        return;
+    // consumer checks the ring under the lock, so it cannot miss this notification
+    std::unique_lock lk(wait_mutex);
+    wait_cv.notify_one();
+}
+
+bool BuildEvents::ready() const
+{
+    return slots[tail & mask].seq.load() == tail + 1;
+}
+
+bool BuildEvents::pop(BuildEvent &e)
+{
+    auto &s = slots[tail & mask];
+    if (s.seq.load(std::memory_order_acquire) != tail + 1)
+        return false;
+    e = std::move(s.e);
+    s.seq.store(tail + mask + 1, std::memory_order_release);
+    tail++;
+    return true;
+}
+
+void BuildEvents::run()
+{
+    BuildEvent e;
+    while (!stopped)
+    {
+        size_t n = 0;
+        {
+            std::unique_lock lk(consumers_mutex);
+            while (pop(e))
+            {
+                for (auto &c : consumers)
+                {
+                    try
+                    {
+                        c->onEvent(e);
+                    }
+                    catch (std::exception &ex)
+                    {
+                        LOG_ERROR(logger, "build event consumer error: " << ex.what());
+                    }
+                }
+                n++;
+            }
+        }
+        consumed += n;
+        if (n)
+            continue;
+
+        // nothing to do, sleep until push() or stop()
+        std::unique_lock lk(wait_mutex);
+        sleeping = true;
+        wait_cv.wait(lk, [this] { return stopped || ready(); });
+        sleeping = false;
+    }
+}
+
+void BuildEvents::addConsumer(std::unique_ptr<BuildEventConsumer> c)
+{
+    std::unique_lock lk(consumers_mutex);
+    consumers.push_back(std::move(c));
+}
+
+void BuildEvents::flush()
+{
+    auto target = head.load();
+    if (target == 0)
+        return;
+    while (consumed < target && !stopped)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::unique_lock lk(consumers_mutex);
+    for (auto &c : consumers)
+        c->flush();
+}
+
+void BuildEvents::stop()
+{
+    if (closed.exchange(true))
+        return;
+    flush();
+    {
+        std::unique_lock lk(wait_mutex);
+        stopped = true;
+    }
+    wait_cv.notify_one();
+    if (t.joinable())
+        t.join();
+
+    // destroy consumers, so their files are closed
+    std::unique_lock lk(consumers_mutex);
+    for (auto &c : consumers)
+        c->flush();
+    consumers.clear();
+}
+
+BuildEvents &getBuildEvents()
+{
+    // leaked, so consumer thread outlives all users during shutdown,
+    // users call flush() when they are done and stop() on exit
+    static auto e = []
+    {
+        auto e = new BuildEvents;
+        e->addConsumer(std::make_unique<ConsoleConsumer>());
+        if (write_build_events)
+            e->addConsumer(std::make_unique<JsonLinesConsumer>(SW_BUILD_EVENTS_FILE));
+        return e;
+    }();
+    return *e;
+}
+
+}
@@ -0,0 +1,112 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/filesystem.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sw
+{
+
+struct SW_BUILDER_API BuildEvent
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum Type : uint8_t
+    {
+        Start,
+        Finish,
+        Outdated,
+        Output,
+    };
+
+    Type type = Start;
+    Clock::time_point time;
+    std::thread::id tid;
+    size_t index = 0; // start: [index/total]
+    size_t total = 0;
+    bool success = true; // finish
+    String subject; // outdated: what is outdated (command, file)
+    String name;
+    String text; // log line, outdated reason or output
+};
+
+struct SW_BUILDER_API BuildEventConsumer
+{
+    virtual ~BuildEventConsumer() = default;
+
+    virtual void onEvent(const BuildEvent &) = 0;
+    virtual void flush() {}
+};
+
+/// Stream of build events.
+///
+/// Producers (commands on executor threads) push events into a lock-free
+/// bounded ring, a single thread drains it in batches and passes events to consumers.
+/// When the ring is full, producers wait. When it is empty, the thread sleeps until the next push.
+struct SW_BUILDER_API BuildEvents
+{
+    BuildEvents(size_t ring_size = 1 << 12);
+    BuildEvents(const BuildEvents &) = delete;
+    BuildEvents &operator=(const BuildEvents &) = delete;
+    ~BuildEvents();
+
+    void push(BuildEvent &&);
+    void addConsumer(std::unique_ptr<BuildEventConsumer>);
+
+    /// waits until all events pushed before this call are consumed
+    void flush();
+
+    /// consumes pending events, flushes and closes consumers, stops the thread;
+    /// events pushed after this call are dropped
+    void stop();
+
+private:
+    struct Slot
+    {
+        std::atomic_size_t seq;
+        BuildEvent e;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    std::atomic_size_t head = 0; // next push position
+    size_t tail = 0; // next pop position, consumer thread only
+    std::atomic_size_t consumed = 0;
+
+    std::mutex consumers_mutex;
+    std::vector<std::unique_ptr<BuildEventConsumer>> consumers;
+
+    std::atomic_bool stopped = false;
+    std::atomic_bool closed = false;
+
+    // idle consumer thread waits here
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+    std::atomic_bool sleeping = false;
+    std::once_flag started;
+    std::thread t;
+
+    bool pop(BuildEvent &);
+    bool ready() const;
+    void notify();
+    void run();
+    void start();
+};
+
+/// process wide event stream
+SW_BUILDER_API
+BuildEvents &getBuildEvents();
+
+}
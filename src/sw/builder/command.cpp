@@ -9,12 +9,14 @@
 #define BOOST_THREAD_VERSION 5
 #include "command.h"
 
+#include "build_events.h"
 #include "command_storage.h"
 #include "file.h"
 #include "file_storage.h"
 #include "jumppad.h"
 #include "os.h"
 #include "program.h"
+#include "spawn.h"
 #include "sw_context.h"
 
 #include <sw/support/filesystem.h>
@@ -38,6 +40,7 @@ DECLARE_STATIC_LOGGER(logger, "command");
 bool save_failed_commands;
 bool save_all_commands;
 bool save_executed_commands;
+bool disable_fast_spawn;
 
 bool explain_outdated;
 bool explain_outdated_full;
@@ -381,7 +384,16 @@ void Command::execute()
     if (!beforeCommand())
         return;
 
-    execute1(); // main call
+    try
+    {
+        execute1(); // main call
+    }
+    catch (...)
+    {
+        printFinish(false);
+        throw;
+    }
+    printFinish(true);
 
     // when we are here, we disable free_user() call,
     // because it will be called in afterCommand()
@@ -394,6 +406,7 @@ void Command::execute(std::error_code &ec)
     if (!beforeCommand())
         return;
     execute1(&ec); // main thing
+    printFinish(!ec);
     if (ec)
         return;
     afterCommand();
@@ -487,6 +500,61 @@ path Command::getResponseFilename() const
     return unique_path() += ".rsp";
 }
 
+static path getResponseFilesDir()
+{
+    return fs::current_path() / SW_BINARY_DIR / "rsp" / "cache";
+}
+
+// response files are reused between runs,
+// remove ones that were not used for a while
+static void cleanupResponseFiles()
+{
+    static std::once_flag f;
+    std::call_once(f, []
+    {
+        static constexpr auto max_age = std::chrono::hours(24 * 7);
+
+        error_code ec;
+        auto now = fs::file_time_type::clock::now();
+        for (auto &e : fs::directory_iterator(getResponseFilesDir(), ec))
+        {
+            auto t = fs::last_write_time(e, ec);
+            if (!ec && now - t > max_age)
+                fs::remove(e, ec);
+        }
+    });
+}
+
+path Command::writeResponseFile() const
+{
+    cleanupResponseFiles();
+
+    // content addressed
+    auto rsp = getResponseFileContents(true);
+    auto h = getHash();
+    hash_combine(h, std::hash<String>()(rsp));
+    auto fn = getResponseFilesDir() / (std::to_string(h) + ".rsp");
+
+    error_code ec;
+    if (fs::exists(fn, ec))
+    {
+        // keep used files from cleanup
+        auto now = fs::file_time_type::clock::now();
+        auto t = fs::last_write_time(fn, ec);
+        if (!ec && now - t > std::chrono::hours(24))
+            fs::last_write_time(fn, now, ec);
+        return fn;
+    }
+
+    // other commands may use the same file concurrently
+    auto tmp = path(fn) += "." + getResponseFilename().string();
+    write_file(tmp, rsp);
+    fs::rename(tmp, fn, ec);
+    if (ec)
+        fs::remove(tmp, ec);
+    return fn;
+}
+
 String Command::getResponseFileContents(bool showIncludes) const
 {
     String rsp;
@@ -538,26 +606,16 @@ void Command::execute1(std::error_code *ec)
     // Try to construct command line first.
     // Some systems have limitation on its length.
 
-    path rsp_file;
     if (needsResponseFile())
     {
-        auto t = temp_directory_path() / getResponseFilename();
-        auto fn = t.filename();
-        t = t.parent_path();
-        rsp_file = t / getProgramName() / "rsp" / fn;
-        write_file(rsp_file, getResponseFileContents(true));
+        auto rsp_file = writeResponseFile();
 
+        rsp_args.clear();
         for (int i = 0; i < getFirstResponseFileArgument(); i++)
             rsp_args.push_back(arguments[i]->clone());
         rsp_args.push_back("@" + rsp_file.u8string());
     }
 
-    SCOPE_EXIT
-    {
-        if (!rsp_file.empty())
-            fs::remove(rsp_file);
-    };
-
     auto make_error_string = [this]()
     {
         postProcess(false);
@@ -574,7 +632,7 @@ void Command::execute1(std::error_code *ec)
 
     if (ec)
     {
-        Base::execute(*ec);
+        executeProcess(*ec);
         if (ec)
         {
             // TODO: save error string
@@ -585,7 +643,7 @@ void Command::execute1(std::error_code *ec)
     else
     {
         std::error_code ec;
-        Base::execute(ec);
+        executeProcess(ec);
         if (ec)
         {
             auto err = make_error_string();
@@ -593,15 +651,28 @@ void Command::execute1(std::error_code *ec)
         }
     }
 
-    if (save_executed_commands || save_all_commands)
-    {
-        saveCommand();
-    }
+    saveExecutedCommand();
 
     postProcess(); // process deps
     printOutputs();
 }
 
+void Command::executeProcess(std::error_code &ec)
+{
+    if (disable_fast_spawn || !canSpawnProcess(*this))
+    {
+        Base::execute(ec);
+        return;
+    }
+
+    auto p = getProgram();
+    if (!p.is_absolute())
+        p = resolveProgram(p);
+    onBeforeRun();
+    spawnProcess(*this, p, ec);
+    onEnd();
+}
+
 void Command::printOutputs()
 {
     if (!show_output)
@@ -620,13 +691,24 @@ void Command::printOutputs()
     if (write_output_to_file)
         write_file(fs::current_path() / SW_BINARY_DIR / "rsp" / std::to_string(getHash()) += ".txt", s);
     else
-        LOG_INFO(logger, s);
+    {
+        // same stream as start lines
+        BuildEvent e;
+        e.type = BuildEvent::Output;
+        e.time = BuildEvent::Clock::now();
+        e.tid = std::this_thread::get_id();
+        e.name = getName();
+        e.text = s;
+        getBuildEvents().push(std::move(e));
+    }
 }
 
 String Command::makeErrorString()
 {
     auto err = "command failed"s;
     auto errors = getErrors();
+    if (errors.empty() && exit_code && exit_code.value() != 0)
+        err += ": exit code = " + std::to_string(exit_code.value());
     if (errors.empty())
         return makeErrorString(err);
 
@@ -678,6 +760,12 @@ String Command::saveCommand() const
     return s;
 }
 
+void Command::saveExecutedCommand() const
+{
+    if (save_executed_commands || save_all_commands)
+        saveCommand();
+}
+
 path Command::writeCommand(const path &p, bool print_name) const
 {
     auto pbat = p;
@@ -900,10 +988,15 @@ bool Command::needsResponseFile() const
 
 bool Command::needsResponseFile(size_t selected_size) const
 {
-    // 3 = 1 + 2 = space + quotes
-    size_t sz = getProgram().size() + 3;
-    for (auto a = arguments.begin() + getFirstResponseFileArgument(); a != arguments.end(); a++)
-        sz += (*a)->toString().size() + 3;
+    if (!command_line_size)
+    {
+        // 3 = 1 + 2 = space + quotes
+        size_t sz = getProgram().size() + 3;
+        for (auto a = arguments.begin() + getFirstResponseFileArgument(); a != arguments.end(); a++)
+            sz += (*a)->toString().size() + 3;
+        command_line_size = sz;
+    }
+    auto sz = command_line_size;
 
     if (use_response_files)
     {
@@ -950,24 +1043,34 @@ void Command::printLog() const
 {
     if (silent)
         return;
-    static Executor eprinter(1);
     if (current_command)
     {
-        eprinter.push([c = std::static_pointer_cast<const Command>(shared_from_this())]
-        {
-            c->log_string = "[" + std::to_string((*c->current_command)++) + "/" + std::to_string(c->total_commands->load()) + "] " + c->getName();
-
-            // we cannot use this one because we must sync with printOutputs() call, both must use the same logger or (synced)stdout
-            //std::cout << "\r" << log_string;
-
-            // use this when logger won't call endl (custom sink is required)
-            //LOG_INFO(logger, "\r" + log_string);
-
-            LOG_INFO(logger, c->log_string);
-        });
+        BuildEvent e;
+        e.type = BuildEvent::Start;
+        e.time = BuildEvent::Clock::now();
+        e.tid = std::this_thread::get_id();
+        e.index = (*current_command)++;
+        e.total = total_commands->load();
+        e.name = getName();
+        log_string = "[" + std::to_string(e.index) + "/" + std::to_string(e.total) + "] " + e.name;
+        e.text = log_string;
+        getBuildEvents().push(std::move(e));
     }
 }
 
+void Command::printFinish(bool success) const
+{
+    if (silent || !current_command)
+        return;
+    BuildEvent e;
+    e.type = BuildEvent::Finish;
+    e.time = BuildEvent::Clock::now();
+    e.tid = std::this_thread::get_id();
+    e.success = success;
+    e.name = getName();
+    getBuildEvents().push(std::move(e));
+}
+
 void Command::setProgram(std::shared_ptr<Program> p)
 {
     if (p)
@@ -203,6 +203,8 @@ struct SW_BUILDER_API Command : ICastable, CommandNode, detail::ResolvableComman
     void execute(std::error_code &ec) override;
     void clean() const;
     bool isExecuted() const { return pid != -1 || executed_; }
+    /// allows already executed command to be scheduled into another execution plan
+    void resetExecution() { pid = -1; executed_ = false; }
 
     String getName(bool short_name = false) const override;
 
@@ -251,27 +253,35 @@ protected:
 
     virtual bool check_if_file_newer(const path &, const String &what, bool throw_on_missing) const;
 
+    // for commands with own execute1()
+    void postProcess(bool ok = true);
+    String makeErrorString();
+    String makeErrorString(const String &e);
+    String saveCommand() const;
+    void saveExecutedCommand() const;
+    void printOutputs();
+
 private:
     const SwBuilderContext *swctx = nullptr;
     mutable size_t hash = 0;
+    mutable size_t command_line_size = 0;
     Arguments rsp_args;
     mutable String log_string;
 
     virtual void execute1(std::error_code *ec = nullptr);
     virtual size_t getHash1() const;
 
-    void postProcess(bool ok = true);
+    void executeProcess(std::error_code &ec);
+    path writeResponseFile() const;
+
     virtual void postProcess1(bool ok) {}
 
     bool beforeCommand();
     void afterCommand();
     bool isTimeChanged() const;
     void printLog() const;
+    void printFinish(bool success) const;
     size_t getHashAndSave() const;
-    String makeErrorString();
-    String makeErrorString(const String &e);
-    String saveCommand() const;
-    void printOutputs();
 };
 
 struct SW_BUILDER_API CommandSequence : Command
@@ -6,6 +6,8 @@
 
 #include "execution_plan.h"
 
+#include "build_events.h"
+
 #include <sw/support/exceptions.h>
 
 #include <nlohmann/json.hpp>
@@ -81,11 +83,22 @@ void ExecutionPlan::execute(Executor &e) const
             if (throw_on_errors)
                 throw; // don't go futher on DAG by default
         }
+        // several commands may become ready at once, start them in execution order
+        std::vector<T::SPtr> ready;
         for (auto &d : c->dependent_commands)
         {
             if (--d->dependencies_left == 0)
+                ready.push_back(d);
+        }
+        std::sort(ready.begin(), ready.end(), [](const auto &c1, const auto &c2)
+        {
+            return c1->lessDuringExecution(*c2);
+        });
+        if (!ready.empty())
+        {
+            std::unique_lock<std::mutex> lk(m);
+            for (auto &d : ready)
             {
-                std::unique_lock<std::mutex> lk(m);
                 fs.push_back(e.push([&run, d] {run((T *)d.get()); }));
                 all.push_back(fs.back());
             }
@@ -141,6 +154,9 @@ void ExecutionPlan::execute(Executor &e) const
     while (running)
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
+    // print everything before reporting errors
+    getBuildEvents().flush();
+
     // gather exceptions
     for (auto &f : all)
     {
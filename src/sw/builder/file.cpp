@@ -6,11 +6,10 @@
 
 #include "file.h"
 
+#include "build_events.h"
 #include "command.h"
 #include "file_storage.h"
 
-#include <primitives/executor.h>
-
 #include <fstream>
 
 #include <primitives/log.h>
@@ -23,20 +22,48 @@ namespace sw
 
 void explainMessage(const String &subject, bool outdated, const String &reason, const String &name)
 {
-    static Executor explain_executor("explain executor", 1);
-    static std::ofstream o([]()
+    if (!outdated)
+        return;
+
+    struct ExplainConsumer : BuildEventConsumer
     {
-        fs::create_directories(path(CPPAN_FILES_EXPLAIN_FILE).parent_path());
-        return CPPAN_FILES_EXPLAIN_FILE;
-    }()); // goes first
-    explain_executor.push([=]
+        std::ofstream o;
+
+        ExplainConsumer()
+        {
+            fs::create_directories(path(CPPAN_FILES_EXPLAIN_FILE).parent_path());
+            o.open(CPPAN_FILES_EXPLAIN_FILE);
+        }
+
+        void onEvent(const BuildEvent &e) override
+        {
+            if (e.type != BuildEvent::Outdated)
+                return;
+            o << e.subject << ": " << e.name << "\n";
+            o << "outdated\n";
+            o << "reason = " << e.text << "\n" << std::endl;
+        }
+
+        void flush() override
+        {
+            o.flush();
+        }
+    };
+
+    static std::once_flag f;
+    std::call_once(f, []
     {
-        if (!outdated)
-            return;
-        o << subject << ": " << name << "\n";
-        o << "outdated\n";
-        o << "reason = " << reason << "\n" << std::endl;
+        getBuildEvents().addConsumer(std::make_unique<ExplainConsumer>());
     });
+
+    BuildEvent e;
+    e.type = BuildEvent::Outdated;
+    e.time = BuildEvent::Clock::now();
+    e.tid = std::this_thread::get_id();
+    e.subject = subject;
+    e.name = name;
+    e.text = reason;
+    getBuildEvents().push(std::move(e));
 }
 
 FileData::FileData(const FileData &rhs)
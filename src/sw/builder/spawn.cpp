@@ -0,0 +1,268 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "spawn.h"
+
+#include <primitives/templates.h>
+
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// posix_spawn_file_actions_addchdir_np()
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define SW_HAVE_FAST_SPAWN 1
+#endif
+#endif
+
+#ifdef SW_HAVE_FAST_SPAWN
+extern char **environ;
+#endif
+
+namespace sw
+{
+
+namespace
+{
+
+#ifdef SW_HAVE_FAST_SPAWN
+struct ProcessCategory : std::error_category
+{
+    const char *name() const noexcept override { return "process"; }
+    std::string message(int c) const override { return "process exited with code " + std::to_string(c); }
+};
+
+const std::error_category &process_category()
+{
+    static ProcessCategory c;
+    return c;
+}
+
+struct Fd
+{
+    int fd = -1;
+
+    Fd() = default;
+    Fd(const Fd &) = delete;
+    Fd &operator=(const Fd &) = delete;
+    ~Fd() { close(); }
+
+    void close()
+    {
+        if (fd != -1)
+            ::close(fd);
+        fd = -1;
+    }
+};
+
+// redirection of one standard stream
+struct Redirection
+{
+    Fd parent; // our end of the pipe
+    Fd child;
+    String *text = nullptr;
+
+    bool open(const primitives::Command::Stream &s, int target, String &text, std::error_code &ec)
+    {
+        if (!s.file.empty())
+        {
+            int flags = target == STDIN_FILENO ? O_RDONLY : (O_WRONLY | O_CREAT | (s.append ? O_APPEND : O_TRUNC));
+            child.fd = ::open(s.file.c_str(), flags | O_CLOEXEC, 0666);
+            if (child.fd == -1)
+            {
+                ec.assign(errno, std::generic_category());
+                return false;
+            }
+            return true;
+        }
+        if (s.inherit)
+            return true;
+        if (target == STDIN_FILENO)
+        {
+            child.fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+            if (child.fd == -1)
+            {
+                ec.assign(errno, std::generic_category());
+                return false;
+            }
+            return true;
+        }
+        int p[2];
+        if (pipe2(p, O_CLOEXEC) == -1)
+        {
+            ec.assign(errno, std::generic_category());
+            return false;
+        }
+        parent.fd = p[0];
+        child.fd = p[1];
+        this->text = &text;
+        return true;
+    }
+};
+#endif
+
+}
+
+bool canSpawnProcess(const primitives::Command &c)
+{
+#ifdef SW_HAVE_FAST_SPAWN
+    return
+        !c.prev && !c.next &&
+        !c.detached && !c.create_new_console && !c.inherit &&
+        c.in.text.empty();
+#else
+    return false;
+#endif
+}
+
+void spawnProcess(primitives::Command &c, const path &program, std::error_code &ec)
+{
+#ifndef SW_HAVE_FAST_SPAWN
+    ec = std::make_error_code(std::errc::function_not_supported);
+#else
+    // argv
+    std::vector<String> args;
+    const auto &arguments = c.getArguments();
+    args.reserve(arguments.size());
+    for (auto &a : arguments)
+        args.push_back(a->toString());
+    std::vector<char *> argv;
+    argv.reserve(args.size() + 1);
+    for (auto &a : args)
+        argv.push_back(a.data());
+    argv.push_back(nullptr);
+
+    // envp: parent environment with command overrides
+    std::vector<String> env_storage;
+    std::vector<char *> envp;
+    if (!c.environment.empty())
+    {
+        for (auto e = environ; *e; e++)
+        {
+            auto eq = strchr(*e, '=');
+            if (eq && c.environment.find(String(*e, eq)) != c.environment.end())
+                continue;
+            envp.push_back(*e);
+        }
+        env_storage.reserve(c.environment.size());
+        for (auto &[k, v] : c.environment)
+            env_storage.push_back(k + "=" + v);
+        for (auto &e : env_storage)
+            envp.push_back(e.data());
+        envp.push_back(nullptr);
+    }
+
+    Redirection in, out, err;
+    String dummy;
+    if (!in.open(c.in, STDIN_FILENO, dummy, ec) ||
+        !out.open(c.out, STDOUT_FILENO, c.out.text, ec) ||
+        !err.open(c.err, STDERR_FILENO, c.err.text, ec))
+        return;
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    SCOPE_EXIT
+    {
+        posix_spawn_file_actions_destroy(&fa);
+        posix_spawnattr_destroy(&attr);
+    };
+
+    // dup2() clears close-on-exec flag on the target
+    if (in.child.fd != -1)
+        posix_spawn_file_actions_adddup2(&fa, in.child.fd, STDIN_FILENO);
+    if (out.child.fd != -1)
+        posix_spawn_file_actions_adddup2(&fa, out.child.fd, STDOUT_FILENO);
+    if (err.child.fd != -1)
+        posix_spawn_file_actions_adddup2(&fa, err.child.fd, STDERR_FILENO);
+    if (!c.working_directory.empty())
+        posix_spawn_file_actions_addchdir_np(&fa, c.working_directory.c_str());
+
+    // do not pass our signal state to children
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t def;
+    sigemptyset(&def);
+    sigaddset(&def, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &def);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    pid_t pid;
+    auto r = posix_spawn(&pid, program.c_str(), &fa, &attr, argv.data(), envp.empty() ? environ : envp.data());
+    if (r != 0)
+    {
+        ec.assign(r, std::generic_category());
+        return;
+    }
+    c.pid = pid;
+
+    in.child.close();
+    out.child.close();
+    err.child.close();
+
+    // read outputs
+    Redirection *rs[] = { &out, &err };
+    char buf[8192];
+    while (1)
+    {
+        pollfd fds[2];
+        Redirection *active[2];
+        nfds_t n = 0;
+        for (auto rd : rs)
+        {
+            if (rd->parent.fd == -1)
+                continue;
+            fds[n] = { rd->parent.fd, POLLIN, 0 };
+            active[n++] = rd;
+        }
+        if (n == 0)
+            break;
+        if (poll(fds, n, -1) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (nfds_t i = 0; i < n; i++)
+        {
+            if (!fds[i].revents)
+                continue;
+            auto sz = read(fds[i].fd, buf, sizeof(buf));
+            if (sz > 0)
+                active[i]->text->append(buf, sz);
+            else if (sz == 0 || errno != EINTR)
+                active[i]->parent.close();
+        }
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+        {
+            ec.assign(errno, std::generic_category());
+            return;
+        }
+    }
+
+    if (WIFEXITED(status))
+        c.exit_code = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status))
+        c.exit_code = 128 + WTERMSIG(status);
+    if (!c.exit_code || c.exit_code.value() != 0)
+        ec.assign(c.exit_code ? (int)c.exit_code.value() : -1, process_category());
+#endif
+}
+
+}
@@ -0,0 +1,27 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/command.h>
+
+namespace sw
+{
+
+/// Low overhead process start: posix_spawn (vfork-like on glibc),
+/// no shell, pipes are created before spawn and read with poll().
+/// Only plain commands are supported (no pipelines, no stdin text,
+/// no detached or inherited processes). Linux only for now.
+SW_BUILDER_API
+bool canSpawnProcess(const primitives::Command &);
+
+/// Runs command using fast path, fills exit_code, pid and stream texts.
+/// Nonzero exit code or spawn error is reported through ec.
+/// Must be called only when canSpawnProcess() returns true.
+SW_BUILDER_API
+void spawnProcess(primitives::Command &, const path &program, std::error_code &ec);
+
+}
@@ -16,6 +16,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <sw/builder/build_events.h>
 #include <sw/builder/jumppad.h>
 #include <sw/client/common/common.h>
 #include <sw/client/common/command/commands.h>
@@ -351,6 +352,9 @@ int main(int argc, char **argv)
         error = e.what();
     }
 
+    // outputs of commands go before the error, files of consumers are closed
+    getBuildEvents().stop();
+
     if (!error.empty() || supress)
     {
         if (!supress)
@@ -278,6 +278,8 @@ std::vector<sw::TargetSettings> createSettings(sw::SwContext &swctx, const Optio
 
     if (options.static_dependencies)
         initial_settings["static-deps"] = "true";
+    if (options.fast_link)
+        initial_settings["native"]["fast_link"] = "true";
 
     std::vector<sw::TargetSettings> settings;
     settings.push_back(initial_settings);
@@ -601,6 +603,8 @@ std::unique_ptr<sw::SwBuild> createBuild(sw::SwContext &swctx, const Options &op
         bs["build_always"] = "true";
     if (options.use_saved_configs)
         bs["use_saved_configs"] = "true";
+    if (options.saved_configs_json)
+        bs["saved_configs_json"] = "true";
     if (!options.options_build.ide_copy_to_dir.empty())
         bs["build_ide_copy_to_dir"] = normalize_path(options.options_build.ide_copy_to_dir);
     if (!options.options_build.ide_fast_path.empty())
@@ -615,6 +619,8 @@ std::unique_ptr<sw::SwBuild> createBuild(sw::SwContext &swctx, const Options &op
         bs["write_output_to_file"] = "true";
     if (!options.options_build.time_limit.empty())
         bs["time_limit"] = options.options_build.time_limit;
+    if (!options.options_test.shard.empty())
+        bs["test_shard"] = options.options_test.shard;
     if (gVerbose || options.trace)
         bs["measure"] = "true";
     for (auto &t : options.targets_to_build)
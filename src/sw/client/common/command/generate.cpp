@@ -101,6 +101,15 @@ SUBCOMMAND_DECL2(generate)
     }
 
     auto b = createBuildAndPrepare(swctx, options.options_generate.build_arg_generate, options);
+    // vs projects take command lines and files, but commands are never executed,
+    // so targets may skip work needed only for execution (e.g. module scanning);
+    // compilation database is still scanned, so module flags are there for clangd
+    if (generator->getType() == GeneratorType::VisualStudio)
+    {
+        auto bs = b->getSettings();
+        bs["commands_only"] = "true";
+        b->setSettings(bs);
+    }
     b->getExecutionPlan(); // prepare commands
     generator->generate(*b);
 }
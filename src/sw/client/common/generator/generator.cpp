@@ -17,6 +17,8 @@
  */
 
 #include "generator.h"
+#include "ninja_emitter.h"
+#include "program_shortcutter.h"
 
 #include <sw/builder/file.h>
 #include <sw/builder/execution_plan.h>
@@ -25,12 +27,16 @@
 #include <sw/core/sw_context.h>
 #include <sw/manager/storage.h>
 #include <sw/support/filesystem.h>
+#include <sw/support/hash.h>
 
 #include <boost/algorithm/string.hpp>
 #include <nlohmann/json.hpp>
+#include <primitives/executor.h>
 #include <primitives/sw/cl.h>
 #include <primitives/pack.h>
 
+#include <fstream>
+
 #include <primitives/log.h>
 DECLARE_STATIC_LOGGER(logger, "generator");
 
@@ -314,281 +320,13 @@ path VSGenerator::getPathString() const
     return toPathString(vstype);
 }
 
-struct ProgramShortCutter1
-{
-    struct iter
-    {
-        ProgramShortCutter1 &sc;
-        size_t i;
-
-        bool operator!=(const iter &rhs) const { return i != rhs.i; }
-        auto operator*() { return sc.programs.find(sc.nprograms[i]); }
-
-        iter &operator++()
-        {
-            i++;
-            return *this;
-        }
-    };
-
-    ProgramShortCutter1(const String &prefix = "SW_PROGRAM_")
-        : prefix(prefix)
-    {}
-
-    String getProgramName(const String &in)
-    {
-        if (programs[in].empty())
-        {
-            programs[in] = prefix + std::to_string(programs.size());
-            nprograms[programs.size()] = in;
-        }
-        return programs[in];
-    }
-
-    bool empty() const { return programs.empty(); }
-
-    auto begin() const { return iter{ (ProgramShortCutter1 &)*this, 1 }; }
-    auto end() const { return iter{ (ProgramShortCutter1 &)*this, programs.size() + 1 }; }
-
-private:
-    String prefix;
-    std::map<String, String> programs;
-    std::map<size_t, String> nprograms;
-};
-
-struct ProgramShortCutter
-{
-    //                                                           program           alias
-    using F = std::function<void(primitives::Emitter &ctx, const String &, const String &)>;
-
-    ProgramShortCutter(bool print_sc_generated = false)
-        : sc_generated("SW_PROGRAM_GENERATED_")
-        , print_sc_generated(print_sc_generated)
-    {}
-
-    String getProgramName(const String &in, const builder::Command &c, bool *untouched = nullptr)
-    {
-        bool gen = File(c.getProgram(), c.getContext().getFileStorage()).isGeneratedAtAll();
-        if (gen && !print_sc_generated)
-        {
-            if (untouched)
-                *untouched = true;
-            return in;
-        }
-        if (untouched)
-            *untouched = false;
-        auto &progs = gen ? sc_generated : sc;
-        return progs.getProgramName(in);
-    }
-
-    void printPrograms(primitives::Emitter &ctx, F f) const
-    {
-        auto print_progs = [&ctx, &f](const auto &a)
-        {
-            for (const auto &kv : a)
-                f(ctx, kv->first, kv->second);
-        };
-
-        // print programs
-        print_progs(sc);
-        ctx.emptyLines();
-        if (print_sc_generated)
-            print_progs(sc_generated);
-        ctx.emptyLines();
-    }
-
-private:
-    ProgramShortCutter1 sc;
-    ProgramShortCutter1 sc_generated;
-    bool print_sc_generated;
-};
-
-struct NinjaEmitter : primitives::Emitter
-{
-    NinjaEmitter(const SwBuild &b, const path &dir)
-        : dir(dir)
-    {
-        addLine("include " + commands_fn);
-        emptyLines(1);
-
-        auto ep = b.getExecutionPlan();
-
-        for (auto &c : ep.getCommands())
-            addCommand(b, *static_cast<builder::Command*>(c));
-
-        primitives::Emitter ctx_progs;
-        sc.printPrograms(ctx_progs, [](auto &ctx, auto &prog, auto &alias)
-        {
-            ctx.addLine(alias + " = " + prog);
-        });
-        write_file(dir / commands_fn, ctx_progs.getText());
-    }
-
-    Files getCreatedFiles() const
-    {
-        Files files;
-        files.insert(dir / commands_fn);
-        files.insert(getRspDir());
-        return files;
-    }
-
-private:
-    path dir;
-    ProgramShortCutter sc;
-    static inline const String commands_fn = "commands.ninja";
-
-    path getRspDir() const
-    {
-        return dir / "rsp";
-    }
-
-    String getShortName(const path &p)
-    {
-#ifdef _WIN32
-        std::wstring buf(4096, 0);
-        path p2 = normalize_path_windows(p);
-        if (!GetShortPathName(p2.wstring().c_str(), buf.data(), buf.size()))
-            //throw SW_RUNTIME_ERROR("GetShortPathName failed for path: " + p.u8string());
-            return normalize_path(p);
-        return normalize_path(to_string(buf));
-#else
-        return normalize_path(p);
-#endif
-    }
-
-    String prepareString(const SwBuild &b, const String &s, bool quotes = false)
-    {
-        //if (b.getContext().getHostOs().Type != OSType::Windows)
-            //quotes = false;
-
-        auto s2 = s;
-        boost::replace_all(s2, ":", "$:");
-        boost::replace_all(s2, "\"", "\\\"");
-        if (quotes)
-            return "\"" + s2 + "\"";
-        return s2;
-    }
-
-    void addCommand(const SwBuild &b, const builder::Command &c)
-    {
-        bool rsp = c.needsResponseFile();
-        if (b.getContext().getHostOs().Type == OSType::Windows)
-            rsp = c.needsResponseFile(8000);
-        path rsp_dir = getRspDir();
-        path rsp_file = fs::absolute(rsp_dir / (std::to_string(c.getHash()) + ".rsp"));
-        if (rsp)
-            fs::create_directories(rsp_dir);
-
-        auto has_mmd = false;
-        auto prog = c.getProgram();
-
-        addLine("rule c" + std::to_string(c.getHash()));
-        increaseIndent();
-        addLine("description = " + c.getName());
-        addLine("command = ");
-        if (b.getContext().getHostOs().Type == OSType::Windows)
-        {
-            addText("cmd /S /C ");
-            addText("\"");
-        }
-        //else
-        //addText("bash -c ");
-
-        // env
-        for (auto &[k, v] : c.environment)
-        {
-            if (b.getContext().getHostOs().Type == OSType::Windows)
-                addText("set ");
-            addText(k + "=" + v + " ");
-            if (b.getContext().getHostOs().Type == OSType::Windows)
-                addText("&& ");
-        }
-
-        // wdir
-        if (!c.working_directory.empty())
-        {
-            addText("cd ");
-            if (b.getContext().getHostOs().Type == OSType::Windows)
-                addText("/D ");
-            addText(prepareString(b, getShortName(c.working_directory), true) + " && ");
-        }
-
-        // prog
-        bool untouched = false;
-        auto progn = sc.getProgramName(prepareString(b, getShortName(prog), true), c, &untouched);
-        addText((untouched ? "" : "$") + progn + " ");
-
-        // args
-        if (!rsp)
-        {
-            int i = 0;
-            for (auto &a : c.arguments)
-            {
-                // skip exe
-                if (!i++)
-                    continue;
-                addText(prepareString(b, a->toString(), true) + " ");
-                has_mmd |= "-MMD" == a->toString();
-            }
-        }
-        else
-        {
-            addText("@" + rsp_file.u8string() + " ");
-        }
-
-        // redirections
-        if (!c.in.file.empty())
-            addText("< " + prepareString(b, getShortName(c.in.file), true) + " ");
-        if (!c.out.file.empty())
-            addText("> " + prepareString(b, getShortName(c.out.file), true) + " ");
-        if (!c.err.file.empty())
-            addText("2> " + prepareString(b, getShortName(c.err.file), true) + " ");
-
-        //
-        if (b.getContext().getHostOs().Type == OSType::Windows)
-            addText("\"");
-        if (prog.find("cl.exe") != prog.npos)
-            addLine("deps = msvc");
-        else if (has_mmd)
-            addLine("depfile = " + (c.outputs.begin()->parent_path() / (c.outputs.begin()->stem().string() + ".d")).u8string());
-        if (rsp)
-        {
-            addLine("rspfile = " + rsp_file.u8string());
-            addLine("rspfile_content = ");
-            int i = 0;
-            for (auto &a : c.arguments)
-            {
-                // skip exe
-                if (!i++)
-                    continue;
-                addText(prepareString(b, a->toString(), c.protect_args_with_quotes) + " ");
-            }
-        }
-        decreaseIndent();
-        addLine();
-
-        addLine("build ");
-        for (auto &o : c.outputs)
-            addText(prepareString(b, getShortName(o)) + " ");
-        //for (auto &o : c.intermediate)
-            //addText(prepareString(b, getShortName(o)) + " ");
-        addText(": c" + std::to_string(c.getHash()) + " ");
-        for (auto &i : c.inputs)
-            addText(prepareString(b, getShortName(i)) + " ");
-        addLine();
-    }
-};
-
 static Files generate_ninja(const SwBuild &b, const path &root_dir)
 {
     // https://ninja-build.org/manual.html#_writing_your_own_ninja_files
 
-    NinjaEmitter ctx(b, root_dir);
-    write_file(root_dir / "build.ninja", ctx.getText());
-
-    auto files = ctx.getCreatedFiles();
-    files.insert(root_dir / "build.ninja");
-    return files;
+    auto ep = b.getExecutionPlan();
+    NinjaEmitter ctx(ep.getCommands(), root_dir, b.getContext().getHostOs().Type == OSType::Windows);
+    return ctx.getCreatedFiles();
 }
 
 void NinjaGenerator::generate(const SwBuild &b)
@@ -1136,50 +874,116 @@ void CompilationDatabaseGenerator::generate(const SwBuild &b)
     checkForSingleSettingsInputs(b);
 
     const auto d = getRootDirectory(b);
+    const auto fn = d / "compile_commands.json";
+    const auto hash_fn = path(fn) += ".hash";
 
-    auto p = b.getExecutionPlan();
-
-    nlohmann::json j;
+    // commands must be prepared to get their arguments,
+    // but we do not need the whole execution plan
+    std::vector<Commands> targets;
     for (auto &[p, tgts] : b.getTargetsToBuild())
     {
         for (auto &tgt : tgts)
         {
-            for (auto &c : tgt->getCommands())
+            auto cmds = tgt->getCommands();
+            for (auto &c : cmds)
+                c->prepare();
+            targets.push_back(std::move(cmds));
+        }
+    }
+
+    auto str = [](const String &s)
+    {
+        return nlohmann::json(s).dump();
+    };
+
+    auto print_command = [&str](const builder::Command &c)
+    {
+        String s;
+        s += "  {\n";
+        if (!c.working_directory.empty())
+            s += "    \"directory\": " + str(normalize_path(c.working_directory)) + ",\n";
+        if (!c.inputs.empty())
+        {
+            bool cppset = false;
+            for (auto &input : c.inputs)
+            {
+                auto i = exts.find(input.extension().string());
+                if (i == exts.end())
+                    continue;
+                s += "    \"file\": " + str(normalize_path(input)) + ",\n";
+                cppset = true;
+                break;
+            }
+            if (!cppset)
             {
-                nlohmann::json j2;
-                if (!c->working_directory.empty())
-                    j2["directory"] = normalize_path(c->working_directory);
-                if (!c->inputs.empty())
+                for (auto &input : c.inputs)
                 {
-                    bool cppset = false;
-                    for (auto &input : c->inputs)
+                    if (normalize_path(input) != normalize_path(c.getProgram()))
                     {
-                        auto i = exts.find(input.extension().string());
-                        if (i == exts.end())
-                            continue;
-                        j2["file"] = normalize_path(input);
-                        cppset = true;
+                        s += "    \"file\": " + str(normalize_path(input)) + ",\n";
                         break;
                     }
-                    if (!cppset)
-                    {
-                        for (auto &input : c->inputs)
-                        {
-                            if (normalize_path(input) != normalize_path(c->getProgram()))
-                            {
-                                j2["file"] = normalize_path(input);
-                                break;
-                            }
-                        }
-                    }
                 }
-                for (auto &a : c->arguments)
-                    j2["arguments"].push_back(a->toString());
-                j.push_back(j2);
             }
         }
+        s += "    \"arguments\": [";
+        bool first = true;
+        for (auto &a : c.arguments)
+        {
+            if (!first)
+                s += ",";
+            first = false;
+            s += "\n      " + str(a->toString());
+        }
+        s += "\n    ]\n";
+        s += "  }";
+        return s;
+    };
+
+    // entries of every target are printed in parallel
+    // and sorted, because commands are not ordered
+    std::vector<Strings> entries(targets.size());
+    auto &e = getExecutor();
+    Futures<void> futures;
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        futures.push_back(e.push([&targets, &entries, &print_command, i]
+        {
+            for (auto &c : targets[i])
+                entries[i].push_back(print_command(*c));
+            std::sort(entries[i].begin(), entries[i].end());
+        }));
+    }
+    waitAndGet(futures);
+
+    // do not touch the file when nothing is changed,
+    // so tools watching it do not reload it
+    size_t h = 0;
+    for (auto &t : entries)
+    {
+        for (auto &entry : t)
+            hash_combine(h, entry);
+    }
+    if (fs::exists(fn) && fs::exists(hash_fn) && read_file(hash_fn) == std::to_string(h))
+        return;
+
+    fs::create_directories(d);
+    std::ofstream o(fn, std::ios::binary);
+    if (!o)
+        throw SW_RUNTIME_ERROR("Cannot open file: " + normalize_path(fn));
+    o << "[";
+    bool first = true;
+    for (auto &t : entries)
+    {
+        for (auto &entry : t)
+        {
+            o << (first ? "\n" : ",\n") << entry;
+            first = false;
+        }
     }
-    write_file(d / "compile_commands.json", j.dump(2));
+    o << "\n]\n";
+    o.close();
+    write_file(hash_fn, std::to_string(h));
 }
 
 void SwExecutionPlanGenerator::generate(const sw::SwBuild &b)
@@ -0,0 +1,327 @@
+/*
+ * SW - Build System and Package Manager
+ * Copyright (C) 2017-2019 Egor Pugin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ninja_emitter.h"
+
+#include <sw/support/filesystem.h>
+
+#include <boost/algorithm/string.hpp>
+#include <primitives/executor.h>
+
+#include <fstream>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using namespace sw;
+
+static String getShortName(const path &p)
+{
+#ifdef _WIN32
+    std::wstring buf(4096, 0);
+    path p2 = normalize_path_windows(p);
+    if (!GetShortPathName(p2.wstring().c_str(), buf.data(), buf.size()))
+        //throw SW_RUNTIME_ERROR("GetShortPathName failed for path: " + p.u8string());
+        return normalize_path(p);
+    return normalize_path(to_string(buf));
+#else
+    return normalize_path(p);
+#endif
+}
+
+static String escape(const String &s)
+{
+    auto s2 = s;
+    boost::replace_all(s2, "$", "$$");
+    return s2;
+}
+
+static String prepareString(const String &s, bool quotes = false)
+{
+    auto s2 = escape(s);
+    boost::replace_all(s2, ":", "$:");
+    boost::replace_all(s2, "\"", "\\\"");
+    if (quotes)
+        return "\"" + s2 + "\"";
+    return s2;
+}
+
+static String preparePath(const path &p)
+{
+    auto s = prepareString(getShortName(p));
+    boost::replace_all(s, " ", "$ ");
+    return s;
+}
+
+NinjaEmitter::NinjaEmitter(const ExecutionPlan::VecT &cmds, const path &dir, bool windows)
+    : dir(dir)
+    , windows(windows)
+{
+    fs::create_directories(getRspDir());
+    std::ofstream o(dir / build_fn, std::ios::binary);
+    if (!o)
+        throw SW_RUNTIME_ERROR("Cannot open file: " + normalize_path(dir / build_fn));
+    o << "include " << commands_fn << "\n\n";
+
+    // pools must be declared before use
+    for (auto &c : cmds)
+    {
+        auto p = static_cast<builder::Command *>(c)->pool;
+        if (!p || p->n <= 0 || pools.find(p) != pools.end())
+            continue;
+        auto name = "p" + std::to_string(pools.size());
+        pools[p] = name;
+        o << "pool " << name << "\n  depth = " << p->n << "\n\n";
+    }
+
+    // edges are rendered in parallel, rules are named and written in commands order
+    const size_t block_size = 8192;
+    const size_t chunk_size = 256;
+    auto &e = getExecutor();
+    std::vector<Edge> edges;
+    for (size_t block = 0; block < cmds.size(); block += block_size)
+    {
+        edges.clear();
+        edges.resize(std::min(block_size, cmds.size() - block));
+
+        Futures<void> futures;
+        for (size_t chunk = 0; chunk < edges.size(); chunk += chunk_size)
+        {
+            futures.push_back(e.push([this, &cmds, &edges, block, chunk, chunk_size]
+            {
+                for (size_t i = chunk; i < std::min(chunk + chunk_size, edges.size()); i++)
+                    edges[i] = prepareEdge(*static_cast<builder::Command *>(cmds[block + i]));
+            }));
+        }
+        waitAndGet(futures);
+
+        for (auto &edge : edges)
+            writeEdge(o, edge);
+    }
+
+    primitives::Emitter ctx_progs;
+    sc.printPrograms(ctx_progs, [](auto &ctx, auto &prog, auto &alias)
+    {
+        ctx.addLine(alias + " = " + prog);
+    });
+    write_file(dir / commands_fn, ctx_progs.getText());
+}
+
+Files NinjaEmitter::getCreatedFiles() const
+{
+    Files files;
+    files.insert(dir / build_fn);
+    files.insert(dir / commands_fn);
+    files.insert(getRspDir());
+    return files;
+}
+
+path NinjaEmitter::getRspDir() const
+{
+    return dir / "rsp";
+}
+
+NinjaEmitter::Edge NinjaEmitter::prepareEdge(const builder::Command &c) const
+{
+    Edge e;
+    e.c = &c;
+
+    auto add_var = [&e](const String &k, const String &v)
+    {
+        e.variables += "  " + k + " = " + v + "\n";
+    };
+
+    bool rsp = c.needsResponseFile();
+    if (windows)
+        rsp = c.needsResponseFile(8000);
+
+    add_var("desc", escape(c.getName()));
+
+    // env
+    for (auto &[k, v] : c.environment)
+    {
+        if (windows)
+            e.command_prefix += "set ";
+        e.command_prefix += escape(k + "=" + v) + " ";
+        if (windows)
+            e.command_prefix += "&& ";
+    }
+
+    // wdir
+    if (!c.working_directory.empty())
+    {
+        e.command_prefix += "cd ";
+        if (windows)
+            e.command_prefix += "/D ";
+        e.command_prefix += "$wdir && ";
+        add_var("wdir", prepareString(getShortName(c.working_directory), true));
+    }
+
+    e.prog = c.getProgram();
+
+    // args referring inputs or outputs are edge variables,
+    // so commands that differ only in files share the rule
+    std::unordered_set<String> io;
+    Strings outputs;
+    for (auto &f : c.inputs)
+    {
+        io.insert(normalize_path(f));
+        io.insert(f.u8string());
+    }
+    for (auto &f : c.outputs)
+    {
+        io.insert(normalize_path(f));
+        io.insert(f.u8string());
+        outputs.push_back(normalize_path(f));
+        outputs.push_back(f.u8string());
+    }
+
+    auto is_io = [&io, &outputs](const String &a)
+    {
+        if (io.find(a) != io.end())
+            return true;
+        for (auto &o : outputs)
+        {
+            if (a.find(o) != a.npos)
+                return true;
+        }
+        return false;
+    };
+
+    String args;
+    int n_vars = 0;
+    bool has_mmd = false;
+    path depfile;
+    bool next_is_depfile = false;
+    int i = 0;
+    for (auto &a : c.arguments)
+    {
+        // skip exe
+        if (!i++)
+            continue;
+        auto s = a->toString();
+        has_mmd |= s == "-MMD" || s == "-MD";
+
+        // depfile is given as '-MF file' or '-MFfile'
+        bool is_depfile = false;
+        if (next_is_depfile)
+        {
+            depfile = s;
+            is_depfile = true;
+        }
+        else if (s.size() > 3 && s.compare(0, 3, "-MF") == 0)
+        {
+            depfile = s.substr(3);
+            is_depfile = true;
+        }
+        next_is_depfile = s == "-MF";
+
+        auto v = prepareString(s, rsp ? c.protect_args_with_quotes : true);
+        if (is_depfile || is_io(s))
+        {
+            auto k = "a" + std::to_string(n_vars++);
+            add_var(k, v);
+            args += "$" + k + " ";
+        }
+        else
+            args += v + " ";
+    }
+
+    if (!rsp)
+        e.command = args;
+    else
+    {
+        e.command = "@$rspfile ";
+        e.rspfile_content = args;
+        add_var("rspfile", prepareString(fs::absolute(getRspDir() / (std::to_string(c.getHash()) + ".rsp")).u8string()));
+    }
+
+    // redirections
+    auto redirect = [&e, &add_var](const String &op, const String &k, const path &f)
+    {
+        if (f.empty())
+            return;
+        e.command += op + " $" + k + " ";
+        add_var(k, prepareString(getShortName(f), true));
+    };
+    redirect("<", "sw_stdin", c.in.file);
+    redirect(">", "sw_stdout", c.out.file);
+    redirect("2>", "sw_stderr", c.err.file);
+
+    if (e.prog.find("cl.exe") != e.prog.npos)
+        e.deps = "msvc";
+    else if (has_mmd && !c.outputs.empty())
+    {
+        e.deps = "gcc";
+        if (depfile.empty())
+            depfile = c.outputs.begin()->parent_path() / (c.outputs.begin()->stem().string() + ".d");
+        add_var("depfile", prepareString(depfile.u8string()));
+    }
+
+    if (c.pool)
+    {
+        auto p = pools.find(c.pool);
+        if (p != pools.end())
+            add_var("pool", p->second);
+    }
+
+    for (auto &f : c.outputs)
+        e.outputs += " " + preparePath(f);
+    for (auto &f : c.inputs)
+        e.inputs += " " + preparePath(f);
+
+    return e;
+}
+
+void NinjaEmitter::writeEdge(std::ostream &o, const Edge &e)
+{
+    auto key = e.command_prefix + "\n" + e.prog + "\n" + e.command + "\n" + e.rspfile_content + "\n" + e.deps;
+    auto &rule = rules[key];
+    if (rule.empty())
+    {
+        rule = "r" + std::to_string(rules.size());
+
+        bool untouched = false;
+        auto progn = sc.getProgramName(prepareString(getShortName(e.prog), true), *e.c, &untouched);
+
+        o << "rule " << rule << "\n";
+        o << "  description = $desc\n";
+        o << "  command = ";
+        if (windows)
+            o << "cmd /S /C \"";
+        o << e.command_prefix << (untouched ? "" : "$") << progn << " " << e.command;
+        if (windows)
+            o << "\"";
+        o << "\n";
+        if (!e.deps.empty())
+            o << "  deps = " << e.deps << "\n";
+        if (e.deps == "gcc")
+            o << "  depfile = $depfile\n";
+        if (!e.rspfile_content.empty())
+        {
+            o << "  rspfile = $rspfile\n";
+            o << "  rspfile_content = " << e.rspfile_content << "\n";
+        }
+        o << "\n";
+    }
+
+    o << "build" << e.outputs << ": " << rule << e.inputs << "\n";
+    o << e.variables << "\n";
+}
@@ -0,0 +1,64 @@
+/*
+ * SW - Build System and Package Manager
+ * Copyright (C) 2017-2019 Egor Pugin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "program_shortcutter.h"
+
+#include <sw/builder/execution_plan.h>
+
+#include <unordered_map>
+
+/// Writes build.ninja and commands.ninja for commands of the execution plan.
+/// Commands that differ only in their files share one rule.
+struct NinjaEmitter
+{
+    NinjaEmitter(const sw::ExecutionPlan::VecT &commands, const path &dir, bool windows);
+
+    Files getCreatedFiles() const;
+
+    static inline const String build_fn = "build.ninja";
+    static inline const String commands_fn = "commands.ninja";
+
+private:
+    // rule is everything in command except per edge variables
+    struct Edge
+    {
+        const sw::builder::Command *c = nullptr;
+        String prog;
+        // rule parts
+        String command_prefix;
+        String command;
+        String rspfile_content;
+        String deps;
+        // edge parts
+        String outputs;
+        String inputs;
+        String variables;
+    };
+
+    path dir;
+    bool windows;
+    ProgramShortCutter sc;
+    std::unordered_map<String, String> rules;
+    std::unordered_map<const sw::ResourcePool *, String> pools;
+
+    path getRspDir() const;
+    Edge prepareEdge(const sw::builder::Command &) const;
+    void writeEdge(std::ostream &, const Edge &);
+};
@@ -0,0 +1,116 @@
+/*
+ * SW - Build System and Package Manager
+ * Copyright (C) 2017-2019 Egor Pugin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sw/builder/command.h>
+#include <sw/builder/file.h>
+
+#include <primitives/emitter.h>
+
+#include <functional>
+#include <map>
+
+struct ProgramShortCutter1
+{
+    struct iter
+    {
+        ProgramShortCutter1 &sc;
+        size_t i;
+
+        bool operator!=(const iter &rhs) const { return i != rhs.i; }
+        auto operator*() { return sc.programs.find(sc.nprograms[i]); }
+
+        iter &operator++()
+        {
+            i++;
+            return *this;
+        }
+    };
+
+    ProgramShortCutter1(const String &prefix = "SW_PROGRAM_")
+        : prefix(prefix)
+    {}
+
+    String getProgramName(const String &in)
+    {
+        if (programs[in].empty())
+        {
+            programs[in] = prefix + std::to_string(programs.size());
+            nprograms[programs.size()] = in;
+        }
+        return programs[in];
+    }
+
+    bool empty() const { return programs.empty(); }
+
+    auto begin() const { return iter{ (ProgramShortCutter1 &)*this, 1 }; }
+    auto end() const { return iter{ (ProgramShortCutter1 &)*this, programs.size() + 1 }; }
+
+private:
+    String prefix;
+    std::map<String, String> programs;
+    std::map<size_t, String> nprograms;
+};
+
+struct ProgramShortCutter
+{
+    //                                                           program           alias
+    using F = std::function<void(primitives::Emitter &ctx, const String &, const String &)>;
+
+    ProgramShortCutter(bool print_sc_generated = false)
+        : sc_generated("SW_PROGRAM_GENERATED_")
+        , print_sc_generated(print_sc_generated)
+    {}
+
+    String getProgramName(const String &in, const sw::builder::Command &c, bool *untouched = nullptr)
+    {
+        bool gen = sw::File(c.getProgram(), c.getContext().getFileStorage()).isGeneratedAtAll();
+        if (gen && !print_sc_generated)
+        {
+            if (untouched)
+                *untouched = true;
+            return in;
+        }
+        if (untouched)
+            *untouched = false;
+        auto &progs = gen ? sc_generated : sc;
+        return progs.getProgramName(in);
+    }
+
+    void printPrograms(primitives::Emitter &ctx, F f) const
+    {
+        auto print_progs = [&ctx, &f](const auto &a)
+        {
+            for (const auto &kv : a)
+                f(ctx, kv->first, kv->second);
+        };
+
+        // print programs
+        print_progs(sc);
+        ctx.emptyLines();
+        if (print_sc_generated)
+            print_progs(sc_generated);
+        ctx.emptyLines();
+    }
+
+private:
+    ProgramShortCutter1 sc;
+    ProgramShortCutter1 sc_generated;
+    bool print_sc_generated;
+};
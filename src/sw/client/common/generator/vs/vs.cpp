@@ -35,6 +35,7 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <nlohmann/json.hpp>
+#include <primitives/executor.h>
 #include <primitives/http.h>
 #include <primitives/sw/cl.h>
 #ifdef _WIN32
@@ -872,8 +873,12 @@ void Solution::emit(const VSGenerator &g) const
     ::create_link(g.sln_root / fn, lnk, "SW link");
 #endif
 
+    // projects do not share state, so they are written in parallel
+    auto &e = getExecutor();
+    Futures<void> futures;
     for (auto &[n, p] : projects)
-        p.emit(g);
+        futures.push_back(e.push([&g, &p = p] { p.emit(g); }));
+    waitAndGet(futures);
 }
 
 void Solution::emitDirectories(SolutionEmitter &ctx) const
@@ -1487,7 +1492,8 @@ void Project::emitFilters(const VSGenerator &g) const
     ctx.endBlock();
 
     ctx.endProject();
-    write_file(g.sln_root / vs_project_dir / (name + vs_project_ext + ".filters"), ctx.getText());
+    // unchanged files are not touched, so IDE does not reload projects
+    write_file_if_different(g.sln_root / vs_project_dir / (name + vs_project_ext + ".filters"), ctx.getText());
 }
 
 String Project::get_flag_table(const primitives::Command &c, bool throw_on_error)
@@ -1537,7 +1543,8 @@ std::map<String, String> Project::printProperties(const sw::builder::Command &c,
             continue;
         }
 
-        auto &tbl = flag_tables[ft].ftable;
+        // read only here, projects are emitted in parallel
+        const auto &tbl = flag_tables.at(ft).ftable;
 
         auto print = [&arg, &args, &exclude_props, &c, &na, &ft](auto &d)
         {
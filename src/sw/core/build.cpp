@@ -11,6 +11,7 @@
 #include "sw_context.h"
 
 #include <sw/builder/execution_plan.h>
+#include <sw/support/mmap.h>
 
 #include <boost/current_function.hpp>
 #include <magic_enum.hpp>
@@ -39,6 +40,10 @@ DECLARE_STATIC_LOGGER(logger, "build");
 
 #define SW_CURRENT_LOCK_FILE_VERSION 1
 
+// saved configs
+#define BASE_SETTINGS "settings.17"
+#define SETTINGS_FN BASE_SETTINGS ".bin"
+
 namespace sw
 {
 
@@ -400,7 +405,7 @@ void SwBuild::loadPackages(const TargetMap &predefined)
     {
         LOG_TRACE(logger, "build id " << this << " " << BOOST_CURRENT_FUNCTION << " round " << r++);
 
-        std::map<TargetSettings, std::pair<PackageId, TargetContainer *>> load;
+        std::map<FrozenTargetSettings, std::pair<PackageId, TargetContainer *>> load;
         for (const auto &[pkg, tgts] : getTargets())
         {
             for (const auto &tgt : tgts)
@@ -418,7 +423,9 @@ void SwBuild::loadPackages(const TargetMap &predefined)
                         throw SW_RUNTIME_ERROR(tgt->getPackage().toString() + ": No target resolved: " + d->getUnresolvedPackage().toString());
                     }
 
-                    auto k = i->second.findSuitable(d->getSettings());
+                    // dependencies of many targets share settings, frozen ones make repeated lookups cheap
+                    auto &ds = d->getFrozenSettings();
+                    auto k = i->second.findSuitable(ds);
                     if (k != i->second.end())
                     {
                         d->setTarget(**k);
@@ -430,45 +437,40 @@ void SwBuild::loadPackages(const TargetMap &predefined)
                         throw SW_LOGIC_ERROR(tgt->getPackage().toString() + ": predefined target is not resolved: " + d->getUnresolvedPackage().toString());
                     }
 
-                    load.insert({ d->getSettings(), { i->first, &i->second } });
+                    load.insert({ ds, { i->first, &i->second } });
                 }
             }
         }
         if (load.empty())
             break;
         bool loaded = false;
-        for (auto &[s, d] : load)
+        for (auto &[frozen, d] : load)
         {
+            auto &s = frozen.get();
+
             // empty settings mean we want dependency only to be present
             if (s.empty())
                 continue;
 
+            // settings that are equal, but not identical, are different keys here,
+            // so the target may be already loaded with a previous request
+            if (d.second->findSuitable(frozen) != d.second->end())
+                continue;
+
             if (build_settings["use_saved_configs"] == "true" &&
                 build_settings["master_build"] == "true") // allow only in the main build for now
             {
                 LocalPackage p(getContext().getLocalStorage(), d.first);
-                auto cfg = s.getHash();
+                auto &cfg = frozen.getHash();
                 auto base = p.getDirObj(cfg);
-#define BASE_SETTINGS "settings.16"
-#define USE_JSON
-#ifndef USE_JSON
-#define SETTINGS_FN BASE_SETTINGS ".bin"
-#else
-#define SETTINGS_FN BASE_SETTINGS ".json"
-#endif
                 auto sfn = base / SETTINGS_FN;
                 if (fs::exists(sfn))
                 {
-                    LOG_TRACE(logger, "loading " << d.first.toString() << ": " << s.getHash() << " from settings file");
+                    LOG_TRACE(logger, "loading " << d.first.toString() << ": " << cfg << " from settings file");
 
                     auto tgt = std::make_shared<PredefinedTarget>(d.first, s);
-#ifndef USE_JSON
-                    tgt->public_ts = loadSettings(sfn);
-#else
-                    TargetSettings its;
-                    its.mergeFromString(read_file(sfn));
-                    tgt->public_ts = its;
-#endif
+                    MappedFile f(sfn);
+                    tgt->public_ts.mergeFromBinary(f.data(), f.size());
                     getTargets()[tgt->getPackage()].push_back(tgt);
                     loaded = true;
                     continue;
@@ -495,7 +497,7 @@ void SwBuild::loadPackages(const TargetMap &predefined)
                 added = true;
             }
 
-            auto k = d.second->findSuitable(s);
+            auto k = d.second->findSuitable(frozen);
             if (k == d.second->end())
             {
                 String e;
@@ -635,18 +637,20 @@ void SwBuild::execute(ExecutionPlan &p) const
             auto cfg = tgt->getSettings().getHash();
             auto base = p.getDirObj(cfg);
             auto sfn = base / SETTINGS_FN;
-            auto sfncfg = base / BASE_SETTINGS ".cfg";
             auto sptrfn = base / "settings.hash";
 
-            if (!fs::exists(sfn) || !fs::exists(sptrfn) || read_file(sptrfn) != tgt->getInterfaceSettings().getHash())
+            auto h = tgt->getInterfaceSettings().getHash();
+            if (!fs::exists(sfn) || !fs::exists(sptrfn) || read_file(sptrfn) != h)
             {
-#ifndef USE_JSON
-                saveSettings(sfn, tgt->getInterfaceSettings());
-#else
-                write_file(sfn, nlohmann::json::parse(tgt->getInterfaceSettings().toString()).dump(4));
-                write_file(sfncfg, nlohmann::json::parse(tgt->getSettings().toString()).dump(4));
-#endif
-                write_file(sptrfn, tgt->getInterfaceSettings().getHash());
+                write_file(sfn, tgt->getInterfaceSettings().toString(TargetSettings::Binary));
+                write_file(sptrfn, h);
+            }
+
+            // debug output
+            if (build_settings["saved_configs_json"] == "true")
+            {
+                write_file(base / BASE_SETTINGS ".json", nlohmann::json::parse(tgt->getInterfaceSettings().toString()).dump(4));
+                write_file(base / BASE_SETTINGS ".cfg", nlohmann::json::parse(tgt->getSettings().toString()).dump(4));
             }
         }
     }
@@ -1042,47 +1046,122 @@ path SwBuild::getTestDir() const
 
 void SwBuild::test()
 {
-    build();
-
-    auto dir = getTestDir();
-    fs::remove_all(dir); // also make a condition here - what condition?
+    // tests are scheduled into the build plan,
+    // so every test starts as soon as its binary is ready
+    while (state != BuildState::Prepared && step())
+        ;
 
-    // prepare
+    auto dir = getTestDir();
+
+    // gather tests in stable order
+    std::vector<std::pair<path, std::shared_ptr<builder::Command>>> tests;
     for (const auto &[pkg, tgts] : getTargetsToBuild())
     {
         for (auto &tgt : tgts)
         {
             for (auto &c : tgt->getTests())
-            {
-                auto test_dir = dir / tgt->getSettings().getHash() / c->getName();
-                fs::create_directories(test_dir);
+                tests.emplace_back(path(tgt->getSettings().getHash()) / c->getName(), c);
+        }
+    }
+    std::sort(tests.begin(), tests.end(), [](const auto &t1, const auto &t2)
+    {
+        return t1.first < t2.first;
+    });
 
-                c->maybe_unused = builder::Command::MU_TRUE; // why?
+    // shard: i/n, zero based
+    if (build_settings["test_shard"].isValue())
+    {
+        auto v = build_settings["test_shard"].getValue();
+        auto p = v.find('/');
+        size_t i = 0, n = 0;
+        try
+        {
+            if (p == v.npos)
+                throw std::invalid_argument("missing /");
+            i = std::stoull(v.substr(0, p));
+            n = std::stoull(v.substr(p + 1));
+        }
+        catch (std::exception &)
+        {
+            n = 0;
+        }
+        if (n == 0 || i >= n)
+            throw SW_RUNTIME_ERROR("Bad test shard: '" + v + "', expected i/n where 0 <= i < n");
+        decltype(tests) shard;
+        for (size_t k = i; k < tests.size(); k += n)
+            shard.push_back(tests[k]);
+        tests = std::move(shard);
+    }
+
+    // longest first, using durations from previous runs
+    std::vector<std::pair<int64_t, builder::Command *>> durations;
 
-                //
-                c->name = "test: [" + c->name + "]";
-                c->always = true;
-                c->working_directory = test_dir;
-                //c.addPathDirectory(BinaryDir / getSettings().getConfig());
-                c->out.file = test_dir / "stdout.txt";
-                c->err.file = test_dir / "stderr.txt";
+    // prepare
+    Commands cmds = getCommands();
+    for (auto &[key, c] : tests)
+    {
+        auto test_dir = dir / key;
+        fs::create_directories(test_dir);
+
+        c->maybe_unused = builder::Command::MU_TRUE; // why?
+
+        //
+        c->name = "test: [" + c->name + "]";
+        // rerun only when test binary, its inputs, arguments or environment change,
+        // command storage also does not record failed runs
+        c->always = !c->command_storage;
+        c->working_directory = test_dir;
+        //c.addPathDirectory(BinaryDir / getSettings().getConfig());
+        c->out.file = test_dir / "stdout.txt";
+        c->err.file = test_dir / "stderr.txt";
+        c->addOutput(c->out.file);
+        c->addOutput(c->err.file);
+
+        int64_t d = 0;
+        if (fs::exists(test_dir / "duration.txt"))
+        {
+            try
+            {
+                d = std::stoll(read_file(test_dir / "duration.txt"));
+            }
+            catch (std::exception &)
+            {
             }
         }
+        durations.emplace_back(d, c.get());
+
+        cmds.insert(c);
     }
+    std::stable_sort(durations.begin(), durations.end(), [](const auto &d1, const auto &d2)
+    {
+        return d1.first > d2.first;
+    });
+    for (size_t i = 0; i < durations.size(); i++)
+        durations[i].second->strict_order = (int)i + 1;
 
-    // gather commands
-    Commands cmds;
-    for (const auto &[pkg, tgts] : getTargetsToBuild())
+    // record durations of tests that were actually run
+    auto save_durations = [&tests, &dir]()
     {
-        for (auto &tgt : tgts)
+        for (auto &[key, c] : tests)
         {
-            auto c = tgt->getTests();
-            cmds.insert(c.begin(), c.end());
+            if (c->t_begin == builder::Command::Clock::time_point{} || c->t_end <= c->t_begin)
+                continue;
+            auto d = std::chrono::duration_cast<std::chrono::milliseconds>(c->t_end - c->t_begin).count();
+            write_file(dir / key / "duration.txt", std::to_string(d));
         }
-    }
+    };
 
     auto ep = getExecutionPlan(cmds);
-    ep.execute(getExecutor());
+    try
+    {
+        execute(ep);
+    }
+    catch (...)
+    {
+        save_durations();
+        throw;
+    }
+    save_durations();
 }
 
 }
@@ -1089,6 +1089,11 @@ static void detectNonWindowsCompilers(DETECT_ARGS)
     //resolve_and_add("as", "org.gnu.gcc.as"); // not needed
     //resolve_and_add("ld", "org.gnu.gcc.ld"); // not needed
 
+    // linkers for -fuse-ld= in fast link mode,
+    // compiler drivers find them in PATH by these names
+    resolve_and_add("ld.mold", "com.github.rui314.mold");
+    resolve_and_add("ld.lld", "org.LLVM.ld");
+
     resolve_and_add("gcc", "org.gnu.gcc", 1);
     resolve_and_add("g++", "org.gnu.gpp", 1);
 
@@ -1100,7 +1105,6 @@ static void detectNonWindowsCompilers(DETECT_ARGS)
 
     // llvm/clang
     //resolve_and_add("llvm-ar", "org.LLVM.ar"); // not needed
-    //resolve_and_add("lld", "org.LLVM.ld"); // not needed
 
     resolve_and_add("clang", "org.LLVM.clang", 2);
     resolve_and_add("clang++", "org.LLVM.clangpp", 2);
@@ -9,9 +9,19 @@
 #include <sw/builder/os.h>
 #include <sw/support/hash.h>
 
+#include <boost/thread/lock_types.hpp>
+#include <boost/thread/shared_mutex.hpp>
 #include <nlohmann/json.hpp>
 #include <pystring.h>
 
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#define SETTINGS_BINARY_MAGIC 0x53545753 // SWTS
+#define SETTINGS_BINARY_FORMAT_VERSION 1
+
 namespace sw
 {
 
@@ -344,6 +354,9 @@ void TargetSettings::mergeFromString(const String &s, int type)
         mergeFromJson(j);
     }
         break;
+    case Binary:
+        mergeFromBinary((const uint8_t *)s.data(), s.size());
+        break;
     default:
         SW_UNIMPLEMENTED;
     }
@@ -355,6 +368,8 @@ String TargetSettings::toString(int type) const
     {
     case Json:
         return toJson().dump();
+    case Binary:
+        return toBinary();
     default:
         SW_UNIMPLEMENTED;
     }
@@ -401,6 +416,223 @@ nlohmann::json TargetSettings::toJson() const
     return j;
 }
 
+// Binary format:
+//  header: magic, format version, number of strings (all uint32)
+//  strings: size (uint32) + bytes; keys and values are stored once
+//  settings: number of entries (uint32), then for every entry:
+//      key (string id), flags (uint8), type (uint8: 1 - value, 2 - array, 3 - object),
+//      value: string id | number of elements + (type (uint8: 0 - value, 1 - object) + element)... | settings
+// Empty values are not stored. Numbers are in native byte order, files are local.
+
+namespace
+{
+
+enum : uint8_t
+{
+    BinaryNotUsedInHash         = 1,
+    BinaryIgnoreInComparison    = 2,
+};
+
+struct BinarySettingsWriter
+{
+    std::unordered_map<String, uint32_t> ids;
+    std::vector<const String *> strings;
+    String data;
+
+    template <class T>
+    void write(const T &v)
+    {
+        data.append((const char *)&v, sizeof(v));
+    }
+
+    void writeString(const String &s)
+    {
+        auto [i, inserted] = ids.emplace(s, (uint32_t)strings.size());
+        if (inserted)
+            strings.push_back(&i->first);
+        write(i->second);
+    }
+
+    void writeSettings(const TargetSettings &ts)
+    {
+        uint32_t n = 0;
+        for (auto &[k, v] : ts)
+        {
+            if (v)
+                n++;
+        }
+        write(n);
+
+        for (auto &[k, v] : ts)
+        {
+            if (!v)
+                continue;
+            writeString(k);
+            uint8_t flags = 0;
+            if (!v.useInHash())
+                flags |= BinaryNotUsedInHash;
+            if (v.ignoreInComparison())
+                flags |= BinaryIgnoreInComparison;
+            write(flags);
+            if (v.isValue())
+            {
+                write((uint8_t)1);
+                writeString(v.getValue());
+            }
+            else if (v.isArray())
+            {
+                write((uint8_t)2);
+                write((uint32_t)v.getArray().size());
+                for (auto &e : v.getArray())
+                {
+                    if (auto s = std::get_if<TargetSetting::Value>(&e))
+                    {
+                        write((uint8_t)0);
+                        writeString(*s);
+                    }
+                    else
+                    {
+                        write((uint8_t)1);
+                        writeSettings(std::get<TargetSetting::Map>(e));
+                    }
+                }
+            }
+            else
+            {
+                write((uint8_t)3);
+                writeSettings(v.getSettings());
+            }
+        }
+    }
+
+    String getData() const
+    {
+        String out;
+        auto append = [&out](uint32_t v)
+        {
+            out.append((const char *)&v, sizeof(v));
+        };
+        append(SETTINGS_BINARY_MAGIC);
+        append(SETTINGS_BINARY_FORMAT_VERSION);
+        append((uint32_t)strings.size());
+        for (auto s : strings)
+        {
+            append((uint32_t)s->size());
+            out += *s;
+        }
+        out += data;
+        return out;
+    }
+};
+
+struct BinarySettingsReader
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    std::vector<std::string_view> strings;
+
+    BinarySettingsReader(const uint8_t *data, size_t size)
+        : p(data), end(data + size)
+    {
+        if (read<uint32_t>() != SETTINGS_BINARY_MAGIC)
+            throw SW_RUNTIME_ERROR("Bad settings file");
+        if (read<uint32_t>() != SETTINGS_BINARY_FORMAT_VERSION)
+            throw SW_RUNTIME_ERROR("Unsupported settings file version");
+        strings.resize(read<uint32_t>());
+        for (auto &s : strings)
+        {
+            auto sz = read<uint32_t>();
+            check(sz);
+            s = std::string_view((const char *)p, sz);
+            p += sz;
+        }
+    }
+
+    void check(size_t n) const
+    {
+        if ((size_t)(end - p) < n)
+            throw SW_RUNTIME_ERROR("Bad settings file: unexpected end of data");
+    }
+
+    template <class T>
+    T read()
+    {
+        check(sizeof(T));
+        T v;
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+
+    String readString()
+    {
+        auto i = read<uint32_t>();
+        if (i >= strings.size())
+            throw SW_RUNTIME_ERROR("Bad settings file: bad string id");
+        return String(strings[i]);
+    }
+
+    void readSettings(TargetSettings &ts)
+    {
+        auto n = read<uint32_t>();
+        while (n--)
+        {
+            auto &v = ts[readString()];
+            auto flags = read<uint8_t>();
+            switch (read<uint8_t>())
+            {
+            case 1:
+                v = readString();
+                break;
+            case 2:
+            {
+                TargetSetting::Array a;
+                a.resize(read<uint32_t>());
+                for (auto &e : a)
+                {
+                    if (read<uint8_t>() == 0)
+                        e = readString();
+                    else
+                    {
+                        TargetSetting::Map m;
+                        readSettings(m);
+                        e = m;
+                    }
+                }
+                v = a;
+            }
+                break;
+            case 3:
+                if (!v.isObject())
+                    v = TargetSetting::Map();
+                readSettings(v.getSettings());
+                break;
+            default:
+                throw SW_RUNTIME_ERROR("Bad settings file: bad value type");
+            }
+            if (flags & BinaryNotUsedInHash)
+                v.useInHash(false);
+            if (flags & BinaryIgnoreInComparison)
+                v.ignoreInComparison(true);
+        }
+    }
+};
+
+}
+
+String TargetSettings::toBinary() const
+{
+    BinarySettingsWriter w;
+    w.writeSettings(*this);
+    return w.getData();
+}
+
+void TargetSettings::mergeFromBinary(const uint8_t *data, size_t size)
+{
+    BinarySettingsReader r(data, size);
+    r.readSettings(*this);
+}
+
 size_t TargetSetting::getHash1() const
 {
     size_t h = 0;
@@ -441,6 +673,96 @@ size_t TargetSettings::getHash1() const
     return h;
 }
 
+size_t TargetSetting::getStructuralHash() const
+{
+    size_t h = 0;
+    hash_combine(h, required);
+    hash_combine(h, used_in_hash);
+    hash_combine(h, ignore_in_comparison);
+    hash_combine(h, value.index());
+    switch (value.index())
+    {
+    case 1:
+        hash_combine(h, getValue());
+        break;
+    case 2:
+        for (auto &v2 : std::get<Array>(value))
+        {
+            if (v2.index() == 0)
+                hash_combine(h, std::get<Value>(v2));
+            else
+                hash_combine(h, std::get<Map>(v2).getStructuralHash());
+        }
+        break;
+    case 3:
+        hash_combine(h, std::get<Map>(value).getStructuralHash());
+        break;
+    }
+    return h;
+}
+
+size_t TargetSettings::getStructuralHash() const
+{
+    size_t h = 0;
+    for (auto &[k, v] : *this)
+    {
+        hash_combine(h, k);
+        hash_combine(h, v.getStructuralHash());
+    }
+    return h;
+}
+
+bool TargetSetting::isIdentical(const TargetSetting &rhs) const
+{
+    if (required != rhs.required ||
+        used_in_hash != rhs.used_in_hash ||
+        ignore_in_comparison != rhs.ignore_in_comparison ||
+        value.index() != rhs.value.index())
+        return false;
+    switch (value.index())
+    {
+    case 1:
+        return getValue() == rhs.getValue();
+    case 2:
+    {
+        auto &a1 = std::get<Array>(value);
+        auto &a2 = std::get<Array>(rhs.value);
+        if (a1.size() != a2.size())
+            return false;
+        for (size_t i = 0; i < a1.size(); i++)
+        {
+            if (a1[i].index() != a2[i].index())
+                return false;
+            if (a1[i].index() == 0)
+            {
+                if (std::get<Value>(a1[i]) != std::get<Value>(a2[i]))
+                    return false;
+            }
+            else if (!std::get<Map>(a1[i]).isIdentical(std::get<Map>(a2[i])))
+                return false;
+        }
+        return true;
+    }
+    case 3:
+        return std::get<Map>(value).isIdentical(std::get<Map>(rhs.value));
+    }
+    return true;
+}
+
+bool TargetSettings::isIdentical(const TargetSettings &rhs) const
+{
+    if (settings.size() != rhs.settings.size())
+        return false;
+    auto i = rhs.settings.begin();
+    for (auto &[k, v] : settings)
+    {
+        if (k != i->first || !v.isIdentical(i->second))
+            return false;
+        ++i;
+    }
+    return true;
+}
+
 TargetSetting &TargetSettings::operator[](const TargetSettingKey &k)
 {
     return settings.try_emplace(k, TargetSetting{}).first->second;
@@ -459,6 +781,9 @@ const TargetSetting &TargetSettings::operator[](const TargetSettingKey &k) const
 
 bool TargetSettings::operator==(const TargetSettings &rhs) const
 {
+    if (this == &rhs)
+        return true;
+
     for (auto &[k, v] : rhs.settings)
     {
         if (v.ignoreInComparison())
@@ -497,6 +822,9 @@ bool TargetSettings::operator<(const TargetSettings &rhs) const
 
 bool TargetSettings::isSubsetOf(const TargetSettings &s) const
 {
+    if (this == &s)
+        return true;
+
     for (auto &[k, v] : settings)
     {
         // value is missing -> ok
@@ -569,4 +897,92 @@ bool TargetSettings::empty() const
     return settings.empty();
 }
 
+namespace detail
+{
+
+struct FrozenTargetSettingsNode
+{
+    // creation order
+    size_t id;
+    TargetSettings settings;
+    size_t structural_hash;
+    String hash;
+};
+
+}
+
+const detail::FrozenTargetSettingsNode *FrozenTargetSettings::freeze(const TargetSettings &s)
+{
+    // nodes live until the end of the program,
+    // number of distinct configurations is small
+    struct table
+    {
+        boost::shared_mutex m;
+        std::unordered_multimap<size_t, const detail::FrozenTargetSettingsNode *> nodes;
+        size_t next_id = 0;
+    };
+    static auto &t = *new table;
+
+    auto h = s.getStructuralHash();
+    auto find = [&t, &s, h]() -> const detail::FrozenTargetSettingsNode *
+    {
+        auto [b, e] = t.nodes.equal_range(h);
+        for (auto i = b; i != e; ++i)
+        {
+            if (i->second->settings.isIdentical(s))
+                return i->second;
+        }
+        return nullptr;
+    };
+
+    {
+        boost::shared_lock lk(t.m);
+        if (auto n = find())
+            return n;
+    }
+
+    std::unique_lock lk(t.m);
+    if (auto n = find())
+        return n;
+    auto n = new detail::FrozenTargetSettingsNode{ t.next_id++, s, h, s.getHash() };
+    t.nodes.emplace(h, n);
+    return n;
+}
+
+FrozenTargetSettings::FrozenTargetSettings()
+{
+    static const auto empty = freeze({});
+    n = empty;
+}
+
+FrozenTargetSettings::FrozenTargetSettings(const TargetSettings &s)
+    : n(freeze(s))
+{
+}
+
+const TargetSettings &FrozenTargetSettings::get() const
+{
+    return n->settings;
+}
+
+const String &FrozenTargetSettings::getHash() const
+{
+    return n->hash;
+}
+
+size_t FrozenTargetSettings::getStructuralHash() const
+{
+    return n->structural_hash;
+}
+
+size_t FrozenTargetSettings::getId() const
+{
+    return n->id;
+}
+
+bool FrozenTargetSettings::operator<(const FrozenTargetSettings &rhs) const
+{
+    return n->id < rhs.n->id;
+}
+
 } // namespace sw
@@ -25,6 +25,7 @@ using TargetSettingKey = String;
 using TargetSettingValue = String;
 struct TargetSetting;
 struct TargetSettings;
+struct FrozenTargetSettings;
 
 struct SW_CORE_API TargetSettings
 {
@@ -34,6 +35,7 @@ struct SW_CORE_API TargetSettings
 
         Json,
         // yml
+        Binary, // compact binary format, see mergeFromBinary()
 
         Simple      = KeyValue,
     };
@@ -48,6 +50,9 @@ struct SW_CORE_API TargetSettings
     // other merges
     void mergeFromString(const String &s, int type = Json);
     void mergeFromJson(const nlohmann::json &);
+    /// Reads settings written by toString(Binary).
+    /// Data is not referenced after the call, so it can be a mapped file.
+    void mergeFromBinary(const uint8_t *data, size_t size);
 
     String getHash() const;
     String toString(int type = Json) const;
@@ -68,9 +73,15 @@ private:
 
     //String toStringKeyValue() const;
     nlohmann::json toJson() const;
+    String toBinary() const;
     size_t getHash1() const;
+    // unlike getHash1() and operator==, these take all keys and flags into account
+    // (except use counter)
+    size_t getStructuralHash() const;
+    bool isIdentical(const TargetSettings &) const;
 
     friend struct TargetSetting;
+    friend struct FrozenTargetSettings;
 
     //
     // SERIALIZATION_ACCESS
@@ -164,6 +175,8 @@ private:
 
     nlohmann::json toJson() const;
     size_t getHash1() const;
+    size_t getStructuralHash() const;
+    bool isIdentical(const TargetSetting &) const;
     void copy_fields(const TargetSetting &);
 
     friend struct TargetSettings;
@@ -270,6 +283,43 @@ private:
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 };
 
+namespace detail
+{
+
+struct FrozenTargetSettingsNode;
+
+}
+
+/// Immutable, hash-consed settings.
+/// Settings are built with TargetSettings and frozen when they are not going to change anymore.
+/// Identical trees share the same node, so copies are cheap,
+/// equality is a pointer comparison and hashes are calculated only once.
+struct SW_CORE_API FrozenTargetSettings
+{
+    /// empty settings
+    FrozenTargetSettings();
+    FrozenTargetSettings(const TargetSettings &);
+
+    const TargetSettings &get() const;
+    const TargetSettings *operator->() const { return &get(); }
+
+    /// same as TargetSettings::getHash(), but memoized
+    const String &getHash() const;
+    size_t getStructuralHash() const;
+    /// unique id of distinct settings, ids are given in order of freezing
+    size_t getId() const;
+
+    bool operator==(const FrozenTargetSettings &rhs) const { return n == rhs.n; }
+    bool operator!=(const FrozenTargetSettings &rhs) const { return n != rhs.n; }
+    /// orders by id, not by settings values
+    bool operator<(const FrozenTargetSettings &) const;
+
+private:
+    const detail::FrozenTargetSettingsNode *n;
+
+    static const detail::FrozenTargetSettingsNode *freeze(const TargetSettings &);
+};
+
 SW_CORE_API
 TargetSettings toTargetSettings(const struct OS &);
 
@@ -282,3 +332,16 @@ SW_CORE_API
 void saveSettings(const path &archive_fn, const TargetSettings &, int type = 0);
 
 } // namespace sw
+
+namespace std
+{
+
+template<> struct hash<sw::FrozenTargetSettings>
+{
+    size_t operator()(const sw::FrozenTargetSettings &s) const
+    {
+        return s.getStructuralHash();
+    }
+};
+
+}
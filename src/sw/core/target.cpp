@@ -6,6 +6,13 @@
 
 #include "target.h"
 
+#include <sw/support/hash.h>
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace sw
 {
 
@@ -35,36 +42,361 @@ void TargetContainer::clear()
     targets.clear();
 }
 
-TargetContainer::Base::iterator TargetContainer::findEqual(const TargetSettings &s)
+// smaller containers are scanned linearly
+static const size_t index_min_targets = 8;
+
+struct TargetContainer::Index
+{
+    // leaf of settings tree
+    struct KeyIndex
+    {
+        std::vector<TargetSettingKey> path;
+        // targets requiring exact value
+        std::unordered_map<TargetSettingValue, std::vector<size_t>> values;
+        // targets requiring non empty array or object
+        std::vector<size_t> present;
+    };
+
+    // indexed targets, to check that index is still valid
+    std::vector<const ITarget *> targets;
+
+    // findEqual(): buckets by comparison hash
+    std::unordered_set<String> ignored_paths;
+    std::unordered_map<size_t, std::vector<size_t>> by_hash;
+
+    // findSuitable(): leaves of settings of every target are its constraints
+    std::unordered_map<String, KeyIndex> keys;
+    std::vector<size_t> n_constraints;
+
+    // memoized lookups by frozen settings, valid as long as the index is
+    mutable std::mutex m;
+    mutable std::unordered_map<FrozenTargetSettings, size_t> equal;
+    mutable std::unordered_map<FrozenTargetSettings, size_t> suitable;
+
+    Index(const Base &tgts)
+    {
+        targets.reserve(tgts.size());
+        for (auto &t : tgts)
+            targets.push_back(t.get());
+
+        for (auto &t : targets)
+            gatherIgnoredPaths(t->getSettings(), {});
+
+        n_constraints.resize(targets.size());
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            auto &ts = targets[i]->getSettings();
+            by_hash[*getComparisonHash(ts)].push_back(i);
+            std::vector<TargetSettingKey> path;
+            n_constraints[i] = addConstraints(ts, path, {}, i);
+        }
+    }
+
+    bool isValidFor(const Base &tgts) const
+    {
+        if (tgts.size() != targets.size())
+            return false;
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            if (tgts[i].get() != targets[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Equal settings (TargetSettings::operator==) always have equal comparison hash.
+    // Arrays are not hashed, they are compared later.
+    // Returns nothing when settings ignore a key in comparison that is not known to the index.
+    std::optional<size_t> getComparisonHash(const TargetSettings &ts, const String &prefix = {}) const
+    {
+        size_t h = 0;
+        for (auto &[k, v] : ts)
+        {
+            if (!v)
+                continue;
+            // paths are needed only when something is ignored
+            String p;
+            if (!ignored_paths.empty())
+            {
+                p = join(prefix, k);
+                if (ignored_paths.find(p) != ignored_paths.end())
+                    continue;
+            }
+            if (v.ignoreInComparison())
+                return {};
+            hash_combine(h, k);
+            if (v.isValue())
+                hash_combine(h, v.getValue());
+            else if (v.isArray())
+                hash_combine(h, 2);
+            else
+            {
+                auto h2 = getComparisonHash(v.getSettings(), p);
+                if (!h2)
+                    return {};
+                hash_combine(h, *h2);
+            }
+        }
+        return h;
+    }
+
+    // Returns targets which constraints are all satisfied by the provided settings.
+    // This is a superset of targets with isSubsetOf() == true.
+    std::vector<size_t> getSuitableCandidates(const TargetSettings &ts) const
+    {
+        std::vector<size_t> counts(targets.size());
+        for (auto &[_, ki] : keys)
+        {
+            const TargetSetting *v = nullptr;
+            const TargetSettings *m = &ts;
+            bool ignored = false;
+            for (auto &k : ki.path)
+            {
+                v = &(*m)[k];
+                if (v->ignoreInComparison())
+                {
+                    ignored = true;
+                    break;
+                }
+                m = &v->getSettings();
+            }
+            if (!ignored && !*v)
+                continue;
+
+            if (!ignored)
+            {
+                for (auto i : ki.present)
+                    counts[i]++;
+                if (!v->isValue())
+                    continue;
+                auto i = ki.values.find(v->getValue());
+                if (i == ki.values.end())
+                    continue;
+                for (auto j : i->second)
+                    counts[j]++;
+                continue;
+            }
+
+            for (auto i : ki.present)
+                counts[i]++;
+            for (auto &[_, tgts] : ki.values)
+            {
+                for (auto i : tgts)
+                    counts[i]++;
+            }
+        }
+
+        std::vector<size_t> candidates;
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            if (counts[i] == n_constraints[i])
+                candidates.push_back(i);
+        }
+        return candidates;
+    }
+
+    template <class F>
+    size_t memoize(std::unordered_map<FrozenTargetSettings, size_t> &cache, const FrozenTargetSettings &s, F &&f) const
+    {
+        {
+            std::unique_lock lk(m);
+            auto i = cache.find(s);
+            if (i != cache.end())
+                return i->second;
+        }
+        auto r = f();
+        std::unique_lock lk(m);
+        cache.emplace(s, r);
+        return r;
+    }
+
+private:
+    static String join(const String &prefix, const TargetSettingKey &k)
+    {
+        auto p = prefix;
+        p += '\0';
+        p += k;
+        return p;
+    }
+
+    void gatherIgnoredPaths(const TargetSettings &ts, const String &prefix)
+    {
+        for (auto &[k, v] : ts)
+        {
+            if (!v)
+                continue;
+            auto p = join(prefix, k);
+            if (v.ignoreInComparison())
+                ignored_paths.insert(p);
+            else if (v.isObject())
+                gatherIgnoredPaths(v.getSettings(), p);
+        }
+    }
+
+    // returns number of added constraints (leaves)
+    size_t addConstraints(const TargetSettings &ts, std::vector<TargetSettingKey> &path, const String &prefix, size_t i)
+    {
+        size_t n = 0;
+        for (auto &[k, v] : ts)
+        {
+            if (!v || v.ignoreInComparison())
+                continue;
+            path.push_back(k);
+            auto p = join(prefix, k);
+            if (v.isValue())
+            {
+                getKeyIndex(p, path).values[v.getValue()].push_back(i);
+                n++;
+            }
+            else
+            {
+                size_t n2 = 0;
+                if (v.isObject())
+                    n2 = addConstraints(v.getSettings(), path, p, i);
+                if (n2 == 0)
+                {
+                    // array or object without constraints
+                    getKeyIndex(p, path).present.push_back(i);
+                    n2 = 1;
+                }
+                n += n2;
+            }
+            path.pop_back();
+        }
+        return n;
+    }
+
+    KeyIndex &getKeyIndex(const String &p, const std::vector<TargetSettingKey> &path)
+    {
+        auto &ki = keys[p];
+        if (ki.path.empty())
+            ki.path = path;
+        return ki;
+    }
+};
+
+std::shared_ptr<const TargetContainer::Index> TargetContainer::getIndex() const
 {
-    return std::find_if(begin(), end(), [&s](const auto &t)
+    if (targets.size() < index_min_targets)
+        return {};
+    auto i = std::atomic_load(&index);
+    if (i && i->isValidFor(targets))
+        return i;
+    i = std::make_shared<const Index>(targets);
+    std::atomic_store(&index, i);
+    return i;
+}
+
+size_t TargetContainer::findEqual1(const TargetSettings &s) const
+{
+    auto equal = [this, &s](size_t i)
+    {
+        return targets[i]->getSettings() == s;
+    };
+
+    auto idx = getIndex();
+    auto h = idx ? idx->getComparisonHash(s) : std::nullopt;
+    if (!h)
+    {
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            if (equal(i))
+                return i;
+        }
+        return targets.size();
+    }
+
+    auto b = idx->by_hash.find(*h);
+    if (b == idx->by_hash.end())
+        return targets.size();
+    for (auto i : b->second)
     {
-        return t->getSettings() == s;
-    });
+        if (equal(i))
+            return i;
+    }
+    return targets.size();
 }
 
-TargetContainer::Base::const_iterator TargetContainer::findEqual(const TargetSettings &s) const
+size_t TargetContainer::findSuitable1(const TargetSettings &s) const
 {
-    return std::find_if(begin(), end(), [&s](const auto &t)
+    auto suitable = [this, &s](size_t i)
     {
-        return t->getSettings() == s;
-    });
+        return targets[i]->getSettings().isSubsetOf(s);
+    };
+
+    auto idx = getIndex();
+    if (!idx)
+    {
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            if (suitable(i))
+                return i;
+        }
+        return targets.size();
+    }
+
+    for (auto i : idx->getSuitableCandidates(s))
+    {
+        if (suitable(i))
+            return i;
+    }
+    return targets.size();
+}
+
+size_t TargetContainer::findEqual1(const FrozenTargetSettings &s) const
+{
+    auto idx = getIndex();
+    if (!idx)
+        return findEqual1(s.get());
+    return idx->memoize(idx->equal, s, [this, &s]() { return findEqual1(s.get()); });
+}
+
+size_t TargetContainer::findSuitable1(const FrozenTargetSettings &s) const
+{
+    auto idx = getIndex();
+    if (!idx)
+        return findSuitable1(s.get());
+    return idx->memoize(idx->suitable, s, [this, &s]() { return findSuitable1(s.get()); });
+}
+
+TargetContainer::Base::iterator TargetContainer::findEqual(const TargetSettings &s)
+{
+    return begin() + findEqual1(s);
+}
+
+TargetContainer::Base::const_iterator TargetContainer::findEqual(const TargetSettings &s) const
+{
+    return begin() + findEqual1(s);
 }
 
 TargetContainer::Base::iterator TargetContainer::findSuitable(const TargetSettings &s)
 {
-    return std::find_if(begin(), end(), [&s](const auto &t)
-    {
-        return t->getSettings().isSubsetOf(s);
-    });
+    return begin() + findSuitable1(s);
 }
 
 TargetContainer::Base::const_iterator TargetContainer::findSuitable(const TargetSettings &s) const
 {
-    return std::find_if(begin(), end(), [&s](const auto &t)
-    {
-        return t->getSettings().isSubsetOf(s);
-    });
+    return begin() + findSuitable1(s);
+}
+
+TargetContainer::Base::iterator TargetContainer::findEqual(const FrozenTargetSettings &s)
+{
+    return begin() + findEqual1(s);
+}
+
+TargetContainer::Base::const_iterator TargetContainer::findEqual(const FrozenTargetSettings &s) const
+{
+    return begin() + findEqual1(s);
+}
+
+TargetContainer::Base::iterator TargetContainer::findSuitable(const FrozenTargetSettings &s)
+{
+    return begin() + findSuitable1(s);
+}
+
+TargetContainer::Base::const_iterator TargetContainer::findSuitable(const FrozenTargetSettings &s) const
+{
+    return begin() + findSuitable1(s);
 }
 
 bool TargetContainer::empty() const
@@ -136,6 +468,17 @@ ITarget *TargetMap::find(const UnresolvedPackage &pkg, const TargetSettings &ts)
     return k->get();
 }
 
+ITarget *TargetMap::find(const UnresolvedPackage &pkg, const FrozenTargetSettings &ts) const
+{
+    auto i = find(pkg);
+    if (i == end())
+        return {};
+    auto k = i->second.findSuitable(ts);
+    if (k == i->second.end())
+        return {};
+    return k->get();
+}
+
 PredefinedTarget::PredefinedTarget(const PackageId &id, const TargetSettings &ts)
     : pkg(id), ts(ts)
 {
@@ -150,7 +493,8 @@ struct PredefinedDependency : IDependency
     PredefinedDependency(const PackageId &unresolved_pkg, const TargetSettings &ts) : unresolved_pkg(unresolved_pkg), ts(ts) {}
     virtual ~PredefinedDependency() {}
 
-    const TargetSettings &getSettings() const override { return ts; }
+    const TargetSettings &getSettings() const override { return ts.get(); }
+    const FrozenTargetSettings &getFrozenSettings() const override { return ts; }
     UnresolvedPackage getUnresolvedPackage() const override { return unresolved_pkg; }
     bool isResolved() const override { return t; }
     void setTarget(const ITarget &t) override { this->t = &t; }
@@ -163,7 +507,7 @@ struct PredefinedDependency : IDependency
 
 private:
     PackageId unresolved_pkg;
-    TargetSettings ts;
+    FrozenTargetSettings ts;
     const ITarget *t = nullptr;
 };
 
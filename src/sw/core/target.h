@@ -27,6 +27,8 @@ struct SW_CORE_API IDependency
     virtual ~IDependency() = 0;
 
     virtual const TargetSettings &getSettings() const = 0;
+    /// same settings frozen once, use them for lookups
+    virtual const FrozenTargetSettings &getFrozenSettings() const = 0;
     virtual UnresolvedPackage getUnresolvedPackage() const = 0;
     virtual bool isResolved() const = 0;
     virtual void setTarget(const ITarget &) = 0;
@@ -165,11 +167,16 @@ struct SW_CORE_API TargetContainer
     // find target with equal settings
     Base::iterator findEqual(const TargetSettings &);
     Base::const_iterator findEqual(const TargetSettings &) const;
+    Base::iterator findEqual(const FrozenTargetSettings &);
+    Base::const_iterator findEqual(const FrozenTargetSettings &) const;
 
     // find target with equal subset of provided settings
     // findEqualSubset()
     Base::iterator findSuitable(const TargetSettings &);
     Base::const_iterator findSuitable(const TargetSettings &) const;
+    // lookups with frozen settings are memoized until targets are changed
+    Base::iterator findSuitable(const FrozenTargetSettings &);
+    Base::const_iterator findSuitable(const FrozenTargetSettings &) const;
 
     void push_back(const ITargetPtr &);
 
@@ -186,6 +193,18 @@ struct SW_CORE_API TargetContainer
 
 private:
     std::vector<ITargetPtr> targets;
+
+    // Lookup index over targets' settings.
+    // It is immutable and is rebuilt on the next lookup after targets were changed.
+    // Settings of added targets must not change.
+    struct Index;
+    mutable std::shared_ptr<const Index> index;
+
+    std::shared_ptr<const Index> getIndex() const;
+    size_t findEqual1(const TargetSettings &) const;
+    size_t findSuitable1(const TargetSettings &) const;
+    size_t findEqual1(const FrozenTargetSettings &) const;
+    size_t findSuitable1(const FrozenTargetSettings &) const;
 };
 
 namespace detail
@@ -247,6 +266,7 @@ struct SW_CORE_API TargetMap : PackageVersionMapBase<TargetContainer, std::unord
     detail::SimpleExpected<std::pair<Version, ITarget *>> find(const PackagePath &pp, const TargetSettings &ts) const;
     ITarget *find(const PackageId &pkg, const TargetSettings &ts) const;
     ITarget *find(const UnresolvedPackage &pkg, const TargetSettings &ts) const;
+    ITarget *find(const UnresolvedPackage &pkg, const FrozenTargetSettings &ts) const;
 
     //
 
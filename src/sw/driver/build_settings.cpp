@@ -87,6 +87,10 @@ BuildSettings::BuildSettings(const TargetSettings &ts)
         Native.MT = v == "true";
     IF_END
 
+    IF_KEY("native"]["fast_link")
+        Native.FastLink = v == "true";
+    IF_END
+
 #undef IF_SETTING
 #undef IF_KEY
 #undef IF_END
@@ -196,6 +200,8 @@ TargetSettings BuildSettings::getTargetSettings() const
 
     if (TargetOS.is(OSType::Windows))
         s["native"]["mt"] = Native.MT ? "true" : "false";
+    if (Native.FastLink)
+        s["native"]["fast_link"] = "true";
 
     // debug, release, ...
 
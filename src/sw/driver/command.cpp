@@ -7,6 +7,8 @@
 #include "command.h"
 
 #include "build.h"
+#include "jvm_class.h"
+#include "make_dependencies.h"
 #include "target/native.h"
 
 #include <sw/builder/platform.h>
@@ -16,6 +18,7 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/dll.hpp>
+#include <nlohmann/json.hpp>
 
 #include <primitives/log.h>
 DECLARE_STATIC_LOGGER(logger, "cpp.command");
@@ -253,63 +256,7 @@ void GNUCommand::postProcess1(bool ok)
         return;
     }
 
-    static const std::regex space_r("[^\\\\] ");
-
-    // deps file is a make in form
-    // target: dependencies
-    // deps are split by spaces on several lines with \ at the end of each line except the last one
-    //
-    // example:
-    //
-    // file.o: dep1.cpp dep2.cpp \
-    //  dep1.h dep2.h \
-    //  dep3.h \
-    //  dep4.h
-    //
-
-    auto f = read_file(deps_file);
-
-    // skip target
-    //  use exactly ": " because on windows target is 'C:/path/to/file: '
-    //                                           skip up to this space ^
-    f = f.substr(f.find(": ") + 1);
-
-    FilesOrdered files;
-
-    enum
-    {
-        EMPTY,
-        FILE,
-    };
-    int state = EMPTY;
-    auto p = f.c_str();
-    auto begin = p;
-    while (*p)
-    {
-        switch (state)
-        {
-        case EMPTY:
-            if (isspace(*p) || *p == '\\')
-                break;
-            state = FILE;
-            begin = p;
-            break;
-        case FILE:
-            if (!isspace(*p))
-                break;
-            if (*(p - 1) == '\\')
-                break;
-            String s(begin, p);
-            if (!s.empty())
-            {
-                boost::replace_all(s, "\\ ", " ");
-                files.push_back(fs::u8path(s));
-            }
-            state = EMPTY;
-            break;
-        }
-        p++;
-    }
+    auto files = readMakeDependencies(read_file(deps_file));
 
 #ifndef _WIN32
     for (auto &f : files)
@@ -332,6 +279,366 @@ void GNUCommand::postProcess1(bool ok)
 #endif
 }
 
+
+namespace
+{
+
+struct JvmClassState
+{
+    size_t abi_hash = 0;
+    size_t constants_hash = 0;
+    StringSet references;
+};
+
+struct JvmSourceState
+{
+    size_t hash = 0;
+    StringSet classes;
+};
+
+struct JvmState
+{
+    size_t command_hash = 0;
+    size_t dependencies_hash = 0;
+    std::map<path, JvmSourceState> sources;
+    std::map<String, JvmClassState> classes;
+
+    bool load(const path &fn)
+    {
+        if (!fs::exists(fn))
+            return false;
+        try
+        {
+            auto j = nlohmann::json::parse(read_file(fn));
+            command_hash = j["command"];
+            dependencies_hash = j["dependencies"];
+            for (auto &[k, v] : j["sources"].items())
+            {
+                auto &s = sources[fs::u8path(k)];
+                s.hash = v["hash"];
+                for (auto &c : v["classes"])
+                    s.classes.insert(c.get<String>());
+            }
+            for (auto &[k, v] : j["classes"].items())
+            {
+                auto &c = classes[k];
+                c.abi_hash = v["abi"];
+                c.constants_hash = v["constants"];
+                for (auto &r : v["references"])
+                    c.references.insert(r.get<String>());
+            }
+            return true;
+        }
+        catch (std::exception &e)
+        {
+            LOG_DEBUG(logger, "Bad jvm state file " + normalize_path(fn) + ": " + e.what());
+            *this = {};
+            return false;
+        }
+    }
+
+    void save(const path &fn) const
+    {
+        nlohmann::json j;
+        j["command"] = command_hash;
+        j["dependencies"] = dependencies_hash;
+        for (auto &[k, v] : sources)
+        {
+            auto &s = j["sources"][normalize_path(k)];
+            s["hash"] = v.hash;
+            s["classes"] = v.classes;
+        }
+        for (auto &[k, v] : classes)
+        {
+            auto &c = j["classes"][k];
+            c["abi"] = v.abi_hash;
+            c["constants"] = v.constants_hash;
+            c["references"] = v.references;
+        }
+        write_file(fn, j.dump());
+    }
+};
+
+}
+
+std::shared_ptr<Command> JvmCommand::clone() const
+{
+    return std::make_shared<JvmCommand>(*this);
+}
+
+bool JvmCommand::compile(const std::set<path> &files, std::error_code *ec)
+{
+    StringSet all_sources;
+    for (auto &f : sources)
+        all_sources.insert(f.u8string());
+
+    // sources go to argument file, javac and kotlinc both support it
+    String rsp;
+    for (auto &f : files)
+        rsp += "\"" + normalize_path(f) + "\"\n";
+    auto rsp_file = path(state_file) += ".sources.rsp";
+    write_file(rsp_file, rsp);
+
+    primitives::Command c;
+    c.setProgram(getProgram());
+    for (size_t i = 1; i < arguments.size(); i++)
+    {
+        auto a = arguments[i]->toString();
+        if (all_sources.find(a) == all_sources.end())
+            c.push_back(a);
+    }
+    c.push_back("@" + normalize_path(rsp_file));
+    c.working_directory = working_directory;
+    c.environment = environment;
+
+    LOG_TRACE(logger, c.print());
+
+    std::error_code ec2;
+    c.execute(ec2);
+    out.text += c.out.text;
+    err.text += c.err.text;
+    exit_code = c.exit_code;
+    if (!ec2)
+        return true;
+
+    // same as builder::Command::execute1()
+    postProcess(false);
+    printOutputs();
+    auto e = makeErrorString();
+    if (ec)
+    {
+        *ec = ec2;
+        return false;
+    }
+    throw SW_RUNTIME_ERROR(e);
+}
+
+void JvmCommand::execute1(std::error_code *ec)
+{
+    auto class_file = [this](const String &name)
+    {
+        return classes_dir / fs::u8path(name + ".class");
+    };
+
+    // sources are not included, so new or removed file does not lead to full rebuild
+    size_t command_hash = std::hash<path>()(getProgram());
+    StringSet all_sources;
+    for (auto &f : sources)
+        all_sources.insert(f.u8string());
+    for (size_t i = 1; i < arguments.size(); i++)
+    {
+        auto a = arguments[i]->toString();
+        if (all_sources.find(a) == all_sources.end())
+            hash_combine(command_hash, std::hash<String>()(a));
+    }
+
+    size_t deps_hash = 0;
+    for (auto &f : dependency_abi_files)
+        hash_combine(deps_hash, std::hash<String>()(read_file(f)));
+
+    JvmState old;
+    bool full =
+        !old.load(state_file) ||
+        old.command_hash != command_hash ||
+        old.dependencies_hash != deps_hash ||
+        std::any_of(old.classes.begin(), old.classes.end(), [&class_file](const auto &c) { return !fs::exists(class_file(c.first)); });
+
+    // state is valid only after successful compilation
+    fs::remove(state_file);
+    fs::create_directories(classes_dir);
+
+    JvmState s;
+    s.command_hash = command_hash;
+    s.dependencies_hash = deps_hash;
+    for (auto &f : sources)
+        s.sources[f].hash = std::hash<String>()(read_file(f));
+
+    std::set<path> to_compile;
+    StringSet changed; // classes with changed public abi or removed
+    if (!full)
+    {
+        for (auto &[f, st] : s.sources)
+        {
+            auto i = old.sources.find(f);
+            if (i == old.sources.end() || i->second.hash != st.hash)
+                to_compile.insert(f);
+            else
+                st.classes = i->second.classes;
+        }
+        for (auto &[f, st] : old.sources)
+        {
+            if (s.sources.find(f) != s.sources.end())
+                continue;
+            to_compile.insert(f); // removed
+            for (auto &c : st.classes)
+                changed.insert(c);
+        }
+        if (!partial && !to_compile.empty())
+            full = true;
+    }
+    if (full)
+    {
+        for (auto &[f, st] : s.sources)
+        {
+            to_compile.insert(f);
+            st.classes.clear();
+        }
+    }
+
+    // removed sources
+    for (auto i = to_compile.begin(); i != to_compile.end();)
+    {
+        if (s.sources.find(*i) != s.sources.end())
+        {
+            i++;
+            continue;
+        }
+        for (auto &c : old.sources[*i].classes)
+            fs::remove(class_file(c));
+        i = to_compile.erase(i);
+    }
+
+    for (auto &[f, st] : s.sources)
+    {
+        for (auto &c : st.classes)
+            s.classes[c] = old.classes[c];
+    }
+
+    std::set<path> compiled;
+    while (1)
+    {
+        // users of changed classes
+        for (auto &[f, st] : s.sources)
+        {
+            if (compiled.find(f) != compiled.end() || to_compile.find(f) != to_compile.end())
+                continue;
+            for (auto &c : st.classes)
+            {
+                auto &refs = s.classes[c].references;
+                if (std::any_of(changed.begin(), changed.end(), [&refs](const auto &c) { return refs.find(c) != refs.end(); }))
+                {
+                    to_compile.insert(f);
+                    break;
+                }
+            }
+        }
+        changed.clear();
+        if (to_compile.empty())
+            break;
+
+        // previous outputs of sources being compiled
+        std::map<String, JvmClassState> prev;
+        for (auto &f : to_compile)
+        {
+            auto i = old.sources.find(f);
+            if (full || i == old.sources.end())
+                continue;
+            for (auto &c : i->second.classes)
+            {
+                prev[c] = old.classes[c];
+                s.classes.erase(c);
+                fs::remove(class_file(c));
+            }
+            s.sources[f].classes.clear();
+        }
+        if (full)
+        {
+            // remove everything we created before
+            for (auto &[c, _] : old.classes)
+            {
+                prev[c] = old.classes[c];
+                fs::remove(class_file(c));
+            }
+            s.classes.clear();
+        }
+
+        if (!compile(to_compile, ec))
+            return;
+
+        // new class files are not owned by any source
+        bool constants_changed = false;
+        for (auto &e : fs::recursive_directory_iterator(classes_dir))
+        {
+            if (!e.is_regular_file() || e.path().extension() != ".class")
+                continue;
+            auto name = normalize_path(fs::relative(e.path(), classes_dir));
+            if (s.classes.find(name.substr(0, name.size() - 6)) != s.classes.end())
+                continue;
+            auto info = readJvmClass(e.path(), abi_includes_code);
+
+            // owner: source with the same file name, package dir is used when there are several
+            std::vector<path> owners;
+            for (auto &f : to_compile)
+            {
+                if (f.filename().u8string() == info.source_file)
+                    owners.push_back(f);
+            }
+            if (owners.size() > 1)
+            {
+                auto pkg = fs::u8path(info.name).parent_path();
+                auto i = std::find_if(owners.begin(), owners.end(), [&pkg](const auto &f)
+                {
+                    return boost::ends_with(normalize_path(f.parent_path()), normalize_path(pkg));
+                });
+                if (i != owners.end())
+                    owners = { *i };
+            }
+            // unknown source, be conservative
+            if (owners.empty())
+                owners.assign(to_compile.begin(), to_compile.end());
+            for (auto &f : owners)
+                s.sources[f].classes.insert(info.name);
+
+            auto &c = s.classes[info.name];
+            c.abi_hash = info.abi_hash;
+            c.constants_hash = info.constants_hash;
+            c.references = std::move(info.references);
+
+            auto i = prev.find(info.name);
+            if (i == prev.end() || i->second.abi_hash != c.abi_hash || i->second.constants_hash != c.constants_hash)
+                changed.insert(info.name);
+            if (i != prev.end() && i->second.constants_hash != c.constants_hash)
+                constants_changed = true;
+            if (i != prev.end())
+                prev.erase(i);
+        }
+        for (auto &[c, _] : prev)
+            changed.insert(c);
+
+        compiled.insert(to_compile.begin(), to_compile.end());
+        to_compile.clear();
+        full = false;
+
+        // constants are inlined without references, so recompile everything else
+        if (constants_changed)
+        {
+            for (auto &[f, _] : s.sources)
+            {
+                if (compiled.find(f) == compiled.end())
+                    to_compile.insert(f);
+            }
+        }
+    }
+
+    // public abi of the whole target
+    size_t abi = 0;
+    for (auto &[n, c] : s.classes)
+    {
+        hash_combine(abi, std::hash<String>()(n));
+        hash_combine(abi, c.abi_hash);
+        hash_combine(abi, c.constants_hash);
+    }
+    auto abi_s = std::to_string(abi);
+    if (!fs::exists(abi_file) || read_file(abi_file) != abi_s)
+        write_file(abi_file, abi_s);
+
+    s.save(state_file);
+
+    saveExecutedCommand();
+    postProcess();
+    printOutputs(); // warnings
+}
+
 ///
 
 CommandBuilder::CommandBuilder(const SwBuilderContext &swctx)
@@ -398,6 +398,34 @@ private:
     void postProcess1(bool ok) override;
 };
 
+/// Incremental javac/kotlinc run.
+///
+/// Only changed sources and sources using classes with changed public ABI are recompiled.
+/// Public ABI of all classes is written to abi_file, it is rewritten only when ABI changes,
+/// so dependent targets that take it as input are not rebuilt otherwise.
+struct SW_DRIVER_CPP_API JvmCommand : Command
+{
+    /// sources are passed in subsets, other arguments are passed as is
+    Files sources;
+    path classes_dir;
+    path state_file;
+    path abi_file;
+    /// abi files of dependencies, any change leads to full rebuild
+    Files dependency_abi_files;
+    /// compile changed sources only, otherwise full rebuild on any change
+    bool partial = true;
+    /// inline functions (Kotlin)
+    bool abi_includes_code = false;
+
+    using Command::Command;
+
+    std::shared_ptr<Command> clone() const override;
+
+private:
+    void execute1(std::error_code *ec = nullptr) override;
+    bool compile(const std::set<path> &files, std::error_code *ec);
+};
+
 struct SW_DRIVER_CPP_API CommandBuilder
 {
     mutable std::shared_ptr<Command> c;
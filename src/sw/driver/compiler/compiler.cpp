@@ -973,8 +973,22 @@ void VisualStudioCSharpCompiler::addSourceFile(const path &input_file)
 
 SW_DEFINE_PROGRAM_CLONE(RustCompiler)
 
+SW_CREATE_COMPILER_COMMAND(RustCompiler, driver::GNUCommand)
+
 void RustCompiler::prepareCommand1(const Target &t)
 {
+    auto cmd = std::static_pointer_cast<driver::GNUCommand>(this->cmd);
+
+    // dep-info lists all modules and files included by macros, so inputs are exact
+    cmd->deps_file = path(Output()) += ".d";
+    String emit = "dep-info=" + normalize_path(cmd->deps_file);
+    if (!MetadataOutput.empty())
+    {
+        emit += ",metadata=" + normalize_path(MetadataOutput);
+        cmd->addOutput(MetadataOutput);
+    }
+    Emit = emit + ",link";
+
     getCommandLineOptions<RustCompilerOptions>(cmd.get(), *this);
 }
 
@@ -1026,16 +1040,16 @@ void FortranCompiler::setSourceFile(const path &input_file)
 }
 
 SW_DEFINE_PROGRAM_CLONE(JavaCompiler)
+SW_CREATE_COMPILER_COMMAND(JavaCompiler, driver::JvmCommand)
 
 void JavaCompiler::prepareCommand1(const Target &t)
 {
     getCommandLineOptions<JavaCompilerOptions>(cmd.get(), *this);
 
-    for (auto &f : InputFiles())
-    {
-        auto o = OutputDir() / (f.filename().stem() += ".class");
-        cmd->addOutput(o);
-    }
+    // outputs (class files) are not known in advance, target sets abi file as output
+    auto c = std::static_pointer_cast<driver::JvmCommand>(cmd);
+    c->sources = InputFiles();
+    c->classes_dir = OutputDir();
 }
 
 void JavaCompiler::setOutputDir(const path &output_dir)
@@ -1050,15 +1064,47 @@ void JavaCompiler::setSourceFile(const path &input_file)
 
 SW_DEFINE_PROGRAM_CLONE(KotlinCompiler)
 
+std::shared_ptr<driver::Command> KotlinCompiler::createCommand1(const SwBuilderContext &swctx) const
+{
+    std::shared_ptr<driver::Command> c;
+    if (output_dir)
+        c = std::make_shared<driver::JvmCommand>(swctx);
+    else
+        c = std::make_shared<driver::Command>(swctx);
+    c->setProgram(file);
+    return c;
+}
+
 void KotlinCompiler::prepareCommand1(const Target &t)
 {
     getCommandLineOptions<KotlinCompilerOptions>(cmd.get(), *this);
+
+    if (!output_dir)
+        return;
+
+    auto c = std::static_pointer_cast<driver::JvmCommand>(cmd);
+    c->outputs.erase(Output());
+    c->sources = InputFiles();
+    c->classes_dir = Output();
+    // kotlinc needs module mapping of all files, so no partial compilation;
+    // inline functions make method bodies a part of abi
+    c->partial = false;
+    c->abi_includes_code = true;
 }
 
 void KotlinCompiler::setOutputFile(const path &output_file)
 {
     Output = output_file;
     Output() += ".jar";
+    output_dir = false;
+}
+
+void KotlinCompiler::setOutputDir(const path &dir)
+{
+    Output = dir;
+    // only for jars
+    IncludeRuntime = false;
+    output_dir = true;
 }
 
 void KotlinCompiler::setSourceFile(const path &input_file)
@@ -1094,4 +1140,30 @@ void DCompiler::setSourceFile(const path &input_file)
     InputFiles().insert(input_file);
 }
 
+SW_DEFINE_PROGRAM_CLONE(DModuleCompiler)
+SW_CREATE_COMPILER_COMMAND(DModuleCompiler, driver::GNUCommand)
+
+void DModuleCompiler::prepareCommand1(const Target &t)
+{
+    if (getVersion(swctx, file) < Version(2, 95))
+        throw SW_RUNTIME_ERROR("Compiling D modules separately requires dmd 2.095 or newer (-makedeps)");
+
+    auto cmd = std::static_pointer_cast<driver::GNUCommand>(this->cmd);
+    cmd->name = normalize_path(InputFile());
+    cmd->name_short = InputFile().filename().u8string();
+
+    // imports go to make style deps file
+    DependenciesFile = path(Output()) += ".d";
+    cmd->deps_file = DependenciesFile();
+    cmd->output_dirs.insert(Output().parent_path());
+
+    getCommandLineOptions<DCompilerOptions>(cmd.get(), *this);
+}
+
+void DModuleCompiler::setSourceFile(const path &input_file, const path &output_file)
+{
+    InputFile = input_file;
+    Output = output_file;
+}
+
 }
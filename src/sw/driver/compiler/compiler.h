@@ -111,6 +111,8 @@ struct SW_DRIVER_CPP_API NativeToolchain
 
     // win, vs
     bool MT = false;
+    // lld/mold, split dwarf, thin archives
+    bool FastLink = false;
     // toolset
     // win sdk
     // add XP support
@@ -507,12 +509,18 @@ protected:
 struct SW_DRIVER_CPP_API RustCompiler : Compiler,
     CommandLineOptions<RustCompilerOptions>
 {
+    /// crate metadata (.rmeta) written by the same invocation, enough for dependent library crates
+    path MetadataOutput;
+
     using Compiler::Compiler;
 
     SW_COMMON_COMPILER_API;
 
     void setOutputFile(const path &output_file);
     void setSourceFile(const path &input_file);
+
+protected:
+    std::shared_ptr<driver::Command> createCommand1(const SwBuilderContext &swctx) const override;
 };
 
 struct SW_DRIVER_CPP_API GoCompiler : Compiler,
@@ -550,6 +558,9 @@ struct SW_DRIVER_CPP_API JavaCompiler : Compiler,
     void setOutputDir(const path &output_dir);
     void setSourceFile(const path &input_file);
 
+protected:
+    std::shared_ptr<driver::Command> createCommand1(const SwBuilderContext &swctx) const override;
+
 private:
     //Version gatherVersion() const override { return Program::gatherVersion(file, "-version", "(\\d+)\\.(\\d+)\\.(\\d+)(_(\\d+))?"); }
 };
@@ -562,9 +573,16 @@ struct SW_DRIVER_CPP_API KotlinCompiler : Compiler,
     SW_COMMON_COMPILER_API;
 
     void setOutputFile(const path &output_file);
+    /// compile into classes directory incrementally instead of jar
+    void setOutputDir(const path &output_dir);
     void setSourceFile(const path &input_file);
 
+protected:
+    std::shared_ptr<driver::Command> createCommand1(const SwBuilderContext &swctx) const override;
+
 private:
+    bool output_dir = false;
+
     //Version gatherVersion() const override { return Program::gatherVersion(file, "-version"); }
 };
 
@@ -586,6 +604,20 @@ struct SW_DRIVER_CPP_API DCompiler : NativeLinker,
     void setImportLibrary(const path &out) override {}
 };
 
+/// compiles one D module into object file
+struct SW_DRIVER_CPP_API DModuleCompiler : Compiler,
+    CommandLineOptions<DCompilerOptions>
+{
+    using Compiler::Compiler;
+
+    SW_COMMON_COMPILER_API;
+
+    void setSourceFile(const path &input_file, const path &output_file);
+
+protected:
+    std::shared_ptr<driver::Command> createCommand1(const SwBuilderContext &swctx) const override;
+};
+
 // TODO: compiled
 // VB, VB.NET, Obj-C (check work), Pascal (+Delphi?), swift, dart, cobol, lisp, ada, haskell, F#, erlang
 
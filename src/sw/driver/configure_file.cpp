@@ -0,0 +1,295 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "configure_file.h"
+
+#include <sw/support/exceptions.h>
+
+#include <cstring>
+
+namespace sw
+{
+
+static bool isDefineNameChar(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static bool isVariableNameChar(char c)
+{
+    return isDefineNameChar(c) || c == '/' || c == '.' || c == '+' || c == '-';
+}
+
+static bool isOff(const std::optional<String> &v)
+{
+    return !v || v->empty() || *v == "0";
+}
+
+ConfigureFileTemplate::ConfigureFileTemplate(const String &text, bool undef_replacements)
+    : text(text), undef_replacements(undef_replacements)
+{
+    parse();
+    variable_ids.clear();
+}
+
+std::shared_ptr<const ConfigureFileTemplate> ConfigureFileTemplate::get(const String &text, bool undef_replacements)
+{
+    // templates are shared between all targets and configurations
+    static std::mutex m;
+    static std::unordered_map<size_t, std::shared_ptr<const ConfigureFileTemplate>> templates;
+
+    auto h = std::hash<String>()(text) ^ (size_t)undef_replacements;
+    {
+        std::unique_lock lk(m);
+        auto i = templates.find(h);
+        if (i != templates.end() && i->second->text == text && i->second->undef_replacements == undef_replacements)
+            return i->second;
+    }
+    auto t = std::make_shared<const ConfigureFileTemplate>(text, undef_replacements);
+    std::unique_lock lk(m);
+    templates[h] = t;
+    return t;
+}
+
+size_t ConfigureFileTemplate::addVariable(const String &name)
+{
+    auto [i, inserted] = variable_ids.emplace(name, variables.size());
+    if (inserted)
+        variables.push_back(name);
+    return i->second;
+}
+
+void ConfigureFileTemplate::parseText(const char *b, const char *e, std::vector<Token> &out)
+{
+    auto add_text = [&out](const char *b, const char *e)
+    {
+        if (b == e)
+            return;
+        if (out.empty() || out.back().type != TokenType::Text)
+            out.push_back({ TokenType::Text });
+        out.back().text.append(b, e);
+    };
+
+    auto p = b;
+    auto text_start = b;
+    while (p != e)
+    {
+        // @VAR@ or ${VAR}
+        const char *name_start = nullptr;
+        char close = 0;
+        if (*p == '@')
+        {
+            name_start = p + 1;
+            close = '@';
+        }
+        else if (*p == '$' && p + 1 != e && p[1] == '{')
+        {
+            name_start = p + 2;
+            close = '}';
+        }
+        if (!name_start)
+        {
+            p++;
+            continue;
+        }
+        auto name_end = name_start;
+        while (name_end != e && isVariableNameChar(*name_end))
+            name_end++;
+        if (name_end == name_start || name_end == e || *name_end != close)
+        {
+            p++;
+            continue;
+        }
+        add_text(text_start, p);
+        Token t{ TokenType::Variable };
+        t.var = addVariable(String(name_start, name_end));
+        out.push_back(std::move(t));
+        p = text_start = name_end + 1;
+    }
+    add_text(text_start, e);
+}
+
+void ConfigureFileTemplate::parse()
+{
+    struct Directive
+    {
+        const char *keyword;
+        TokenType type;
+    };
+    // longer keywords first
+    static const Directive directives[] =
+    {
+        { "cmakedefine01", TokenType::CMakeDefine01 },
+        { "cmakedefine", TokenType::CMakeDefine },
+        { "mesondefine", TokenType::MesonDefine },
+        { "undef", TokenType::Undef },
+    };
+
+    auto p = text.data();
+    auto end = text.data() + text.size();
+    while (p != end)
+    {
+        // line and its ending
+        auto eol = p;
+        while (eol != end && *eol != '\r' && *eol != '\n')
+            eol++;
+        auto next = eol;
+        if (next != end)
+            next += (*next == '\r' && next + 1 != end && next[1] == '\n') ? 2 : 1;
+
+        // directives are recognized only on terminated lines
+        const char *directive_start = nullptr;
+        const char *name_start = nullptr;
+        TokenType type = TokenType::Text;
+        for (auto h = p; eol != end && h != eol && !directive_start; h++)
+        {
+            if (*h != '#')
+                continue;
+            for (auto &d : directives)
+            {
+                if (d.type == TokenType::Undef && !undef_replacements)
+                    continue;
+                auto n = strlen(d.keyword);
+                if ((size_t)(eol - h - 1) < n || strncmp(h + 1, d.keyword, n) != 0)
+                    continue;
+                auto ws = h + 1 + n;
+                if (ws == eol || (*ws != ' ' && *ws != '\t'))
+                    continue;
+                while (ws != eol && (*ws == ' ' || *ws == '\t'))
+                    ws++;
+                directive_start = h;
+                name_start = ws;
+                type = d.type;
+                break;
+            }
+        }
+
+        if (!directive_start)
+        {
+            parseText(p, next, tokens);
+            p = next;
+            continue;
+        }
+
+        parseText(p, directive_start, tokens);
+
+        auto name_end = name_start;
+        while (name_end != eol && isDefineNameChar(*name_end))
+            name_end++;
+
+        Token t{ type };
+        t.text.assign(eol, next);
+        t.var = addVariable(String(name_start, name_end));
+        if (type == TokenType::CMakeDefine)
+        {
+            t.rest_begin = rest_tokens.size();
+            parseText(name_end, eol, rest_tokens);
+            t.rest_end = rest_tokens.size();
+        }
+        tokens.push_back(std::move(t));
+        p = next;
+    }
+}
+
+void ConfigureFileTemplate::renderText(const Token *b, const Token *e, const Values &values, String &out) const
+{
+    for (auto t = b; t != e; t++)
+    {
+        if (t->type == TokenType::Text)
+            out += t->text;
+        else if (values[t->var])
+            out += *values[t->var];
+    }
+}
+
+String ConfigureFileTemplate::render(const Values &values) const
+{
+    if (values.size() != variables.size())
+        throw SW_RUNTIME_ERROR("Bad number of configure file values: " + std::to_string(values.size()) +
+            ", expected " + std::to_string(variables.size()));
+
+    String s;
+    s.reserve(text.size());
+    for (auto &t : tokens)
+    {
+        if (t.type == TokenType::Text)
+        {
+            s += t.text;
+            continue;
+        }
+
+        auto &name = variables[t.var];
+        auto &v = values[t.var];
+        switch (t.type)
+        {
+        case TokenType::Variable:
+            if (v)
+                s += *v;
+            break;
+        case TokenType::MesonDefine:
+            if (v)
+                s += "#define " + name + " " + *v;
+            else
+                s += "/* #undef " + name + " */";
+            s += t.text;
+            break;
+        case TokenType::Undef:
+            // undefined variable removes the whole line
+            if (!v)
+                break;
+            if (isOff(v))
+                s += "/* # undef " + name + " */";
+            else
+                s += "#define " + name + " " + *v;
+            s += t.text;
+            break;
+        case TokenType::CMakeDefine:
+        {
+            auto off = isOff(v);
+            s += off ? "/* #undef " : "#define ";
+            s += name;
+            renderText(rest_tokens.data() + t.rest_begin, rest_tokens.data() + t.rest_end, values, s);
+            if (off)
+                s += " */";
+            s += t.text;
+            break;
+        }
+        case TokenType::CMakeDefine01:
+            s += "#define " + name + (isOff(v) ? " 0" : " 1");
+            s += t.text;
+            break;
+        default:
+            break;
+        }
+    }
+    return s;
+}
+
+String ConfigureFileTemplate::configure(const Values &values) const
+{
+    // values of used variables are the key
+    String key;
+    for (auto &v : values)
+    {
+        if (v)
+            key += std::to_string(v->size()) + ":" + *v;
+        else
+            key += "-";
+    }
+
+    {
+        std::unique_lock lk(m);
+        auto i = results.find(key);
+        if (i != results.end())
+            return i->second;
+    }
+    auto s = render(values);
+    std::unique_lock lk(m);
+    results.emplace(std::move(key), s);
+    return s;
+}
+
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/string.h>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace sw
+{
+
+/// Parsed configure file (config.h.in and friends).
+///
+/// Template is tokenized in a single scan, handled forms are
+/// @VAR@, ${VAR}, #mesondefine, #undef (optional), #cmakedefine and #cmakedefine01.
+/// Variables are not expanded recursively.
+struct ConfigureFileTemplate
+{
+    /// variable values in order of getVariables(), nullopt means undefined variable
+    using Values = std::vector<std::optional<String>>;
+
+    ConfigureFileTemplate(const String &text, bool undef_replacements);
+
+    /// returns memoized template for this text
+    static std::shared_ptr<const ConfigureFileTemplate> get(const String &text, bool undef_replacements);
+
+    /// names of variables used in template
+    const Strings &getVariables() const { return variables; }
+
+    String render(const Values &) const;
+
+    /// memoized render()
+    String configure(const Values &) const;
+
+private:
+    enum class TokenType : uint8_t
+    {
+        Text,
+        Variable,
+        MesonDefine,
+        Undef,
+        CMakeDefine,
+        CMakeDefine01,
+    };
+
+    struct Token
+    {
+        TokenType type;
+        String text; // text or directive line ending
+        size_t var = 0; // variable index
+        size_t rest_begin = 0; // #cmakedefine: range of the rest of line in rest_tokens
+        size_t rest_end = 0;
+    };
+
+    String text;
+    bool undef_replacements;
+    Strings variables;
+    std::unordered_map<String, size_t> variable_ids;
+    std::vector<Token> tokens;
+    std::vector<Token> rest_tokens;
+    mutable std::mutex m;
+    mutable std::unordered_map<String, String> results;
+
+    void parse();
+    void parseText(const char *b, const char *e, std::vector<Token> &);
+    size_t addVariable(const String &name);
+    void renderText(const Token *b, const Token *e, const Values &, String &out) const;
+};
+
+}
@@ -13,6 +13,7 @@
 #include <sw/manager/package.h>
 
 #include <memory>
+#include <optional>
 
 namespace sw
 {
@@ -22,7 +23,6 @@ struct ITarget;
 struct SW_DRIVER_CPP_API DependencyData : IDependency
 {
     UnresolvedPackage package;
-    TargetSettings settings;
     bool Disabled = false;
 
     DependencyData(const ITarget &t);
@@ -41,12 +41,19 @@ struct SW_DRIVER_CPP_API DependencyData : IDependency
     TargetSettings &getOptions() { return getSettings()["options"].getSettings(); }
     const TargetSettings &getOptions() const { return getSettings()["options"].getSettings(); }
 
-    TargetSettings &getSettings() { return settings; }
+    /// drops frozen settings, they are frozen again on the next lookup
+    TargetSettings &getSettings();
     const TargetSettings &getSettings() const override { return settings; }
+    const FrozenTargetSettings &getFrozenSettings() const override;
+    void setSettings(const TargetSettings &);
+    /// settings were not changed since the last lookup
+    bool hasFrozenSettings() const { return frozen_settings.has_value(); }
 
     PackageId getResolvedPackage() const;
 
 private:
+    TargetSettings settings;
+    mutable std::optional<FrozenTargetSettings> frozen_settings;
     const ITarget *target = nullptr;
 };
 
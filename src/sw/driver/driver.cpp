@@ -12,6 +12,7 @@
 #include "target/other.h"
 #include "entry_point.h"
 #include "module.h"
+#include "frontend/cppan/yaml.h"
 
 #include <sw/core/input.h>
 #include <sw/core/sw_context.h>
@@ -352,7 +353,9 @@ Driver::EntryPointsVector1 Driver::load_spec_file(SwContext &swctx, const path &
     }
     case FrontendType::Cppan:
     {
-        auto root = YAML::Load(read_file(fn));
+        // unchanged configs are loaded without yaml parsing,
+        // normalization is a no-op for them
+        auto root = cppan::load_yaml_config_cached(read_file(fn), swctx.getLocalStorage().storage_dir_tmp / "cppan");
         auto bf = [root](Build &b) mutable
         {
             b.cppan_load(root);
@@ -18,8 +18,18 @@
 
 #include "project.h"
 
+#include <sw/support/exceptions.h>
+#include <sw/support/hash.h>
+
 #include <boost/algorithm/string.hpp>
 
+#include <cstring>
+#include <unordered_map>
+
+#define CONFIG_BINARY_MAGIC 0x4E505043 // CPPN
+// bump when normalization in prepare_config_for_reading() changes
+#define CONFIG_BINARY_FORMAT_VERSION 1
+
 namespace sw::cppan
 {
 
@@ -99,6 +109,199 @@ yaml load_yaml_config(yaml &root)
     return root;
 }
 
+// Binary format:
+//  header: magic, format version, number of strings (all uint32)
+//  strings: size (uint32) + bytes; every scalar is stored once
+//  node: type (uint8: 0 - null, 1 - scalar, 2 - sequence, 3 - map),
+//      scalar: string id | number of elements + nodes | number of pairs + (key node, value node)...
+// Tags and styles are not stored. Numbers are in native byte order, files are local.
+
+namespace
+{
+
+enum : uint8_t
+{
+    BinaryNull,
+    BinaryScalar,
+    BinarySequence,
+    BinaryMap,
+};
+
+struct BinaryConfigWriter
+{
+    std::unordered_map<String, uint32_t> ids;
+    std::vector<const String *> strings;
+    String data;
+
+    template <class T>
+    void write(const T &v)
+    {
+        data.append((const char *)&v, sizeof(v));
+    }
+
+    void writeNode(const yaml &n)
+    {
+        switch (n.Type())
+        {
+        case YAML::NodeType::Scalar:
+        {
+            write(BinaryScalar);
+            auto [i, inserted] = ids.emplace(n.Scalar(), (uint32_t)strings.size());
+            if (inserted)
+                strings.push_back(&i->first);
+            write(i->second);
+            break;
+        }
+        case YAML::NodeType::Sequence:
+            write(BinarySequence);
+            write((uint32_t)n.size());
+            for (auto e : n)
+                writeNode(e);
+            break;
+        case YAML::NodeType::Map:
+            write(BinaryMap);
+            write((uint32_t)n.size());
+            for (auto e : n)
+            {
+                writeNode(e.first);
+                writeNode(e.second);
+            }
+            break;
+        default:
+            write(BinaryNull);
+            break;
+        }
+    }
+
+    String getData() const
+    {
+        String s;
+        auto w = [&s](uint32_t v) { s.append((const char *)&v, sizeof(v)); };
+        w(CONFIG_BINARY_MAGIC);
+        w(CONFIG_BINARY_FORMAT_VERSION);
+        w((uint32_t)strings.size());
+        for (auto str : strings)
+        {
+            w((uint32_t)str->size());
+            s += *str;
+        }
+        return s + data;
+    }
+};
+
+struct BinaryConfigReader
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    Strings strings;
+
+    template <class T>
+    T read()
+    {
+        if ((size_t)(end - p) < sizeof(T))
+            throw SW_RUNTIME_ERROR("Unexpected end of binary config");
+        T v;
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+
+    void readHeader()
+    {
+        if (read<uint32_t>() != CONFIG_BINARY_MAGIC)
+            throw SW_RUNTIME_ERROR("Not a binary config");
+        if (read<uint32_t>() != CONFIG_BINARY_FORMAT_VERSION)
+            throw SW_RUNTIME_ERROR("Unsupported binary config version");
+        auto n = read<uint32_t>();
+        strings.reserve(n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            auto sz = read<uint32_t>();
+            if ((size_t)(end - p) < sz)
+                throw SW_RUNTIME_ERROR("Unexpected end of binary config");
+            strings.emplace_back((const char *)p, sz);
+            p += sz;
+        }
+    }
+
+    yaml readNode()
+    {
+        switch (read<uint8_t>())
+        {
+        case BinaryNull:
+            return yaml(YAML::NodeType::Null);
+        case BinaryScalar:
+        {
+            auto id = read<uint32_t>();
+            if (id >= strings.size())
+                throw SW_RUNTIME_ERROR("Bad string id in binary config: " + std::to_string(id));
+            return yaml(strings[id]);
+        }
+        case BinarySequence:
+        {
+            yaml n(YAML::NodeType::Sequence);
+            auto sz = read<uint32_t>();
+            for (uint32_t i = 0; i < sz; i++)
+                n.push_back(readNode());
+            return n;
+        }
+        case BinaryMap:
+        {
+            yaml n(YAML::NodeType::Map);
+            auto sz = read<uint32_t>();
+            for (uint32_t i = 0; i < sz; i++)
+            {
+                auto k = readNode();
+                n.force_insert(k, readNode());
+            }
+            return n;
+        }
+        default:
+            throw SW_RUNTIME_ERROR("Bad node type in binary config");
+        }
+    }
+};
+
+}
+
+String save_yaml_config_binary(const yaml &root)
+{
+    BinaryConfigWriter w;
+    w.writeNode(root);
+    return w.getData();
+}
+
+yaml load_yaml_config_binary(const String &data)
+{
+    BinaryConfigReader r{ (const uint8_t *)data.data(), (const uint8_t *)data.data() + data.size() };
+    r.readHeader();
+    auto root = r.readNode();
+    if (r.p != r.end)
+        throw SW_RUNTIME_ERROR("Trailing data in binary config");
+    return root;
+}
+
+yaml load_yaml_config_cached(const String &s, const path &cache_dir)
+{
+    auto fn = cache_dir / (shorten_hash(blake2b_512(s + std::to_string(CONFIG_BINARY_FORMAT_VERSION)), 16) + ".bin");
+    if (fs::exists(fn))
+    {
+        try
+        {
+            return load_yaml_config_binary(read_file(fn));
+        }
+        catch (std::exception &)
+        {
+            // broken cache, parse again
+        }
+    }
+
+    auto root = load_yaml_config(s);
+    fs::create_directories(cache_dir);
+    write_file(fn, save_yaml_config_binary(root));
+    return root;
+}
+
 void dump_yaml_config(const path &p, const yaml &root)
 {
     write_file(p, dump_yaml_config(root));
@@ -27,6 +27,18 @@ yaml load_yaml_config(const path &p);
 yaml load_yaml_config(const String &s);
 yaml load_yaml_config(yaml &root);
 
+/// Normalized config in a compact binary form.
+/// Loading it does not involve yaml parsing.
+SW_DRIVER_CPP_API
+String save_yaml_config_binary(const yaml &root);
+SW_DRIVER_CPP_API
+yaml load_yaml_config_binary(const String &data);
+
+/// Same as load_yaml_config(), but the normalized config is cached in cache_dir
+/// by config contents and binary format version.
+SW_DRIVER_CPP_API
+yaml load_yaml_config_cached(const String &s, const path &cache_dir);
+
 void dump_yaml_config(const path &p, const yaml &root);
 String dump_yaml_config(const yaml &root);
 
@@ -0,0 +1,329 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "jvm_class.h"
+
+#include <sw/support/exceptions.h>
+#include <sw/support/hash.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace sw
+{
+
+namespace
+{
+
+// https://docs.oracle.com/javase/specs/jvms/se13/html/jvms-4.html
+
+enum ConstantTag : uint8_t
+{
+    CONSTANT_Utf8 = 1,
+    CONSTANT_Integer = 3,
+    CONSTANT_Float = 4,
+    CONSTANT_Long = 5,
+    CONSTANT_Double = 6,
+    CONSTANT_Class = 7,
+    CONSTANT_String = 8,
+    CONSTANT_Fieldref = 9,
+    CONSTANT_Methodref = 10,
+    CONSTANT_InterfaceMethodref = 11,
+    CONSTANT_NameAndType = 12,
+    CONSTANT_MethodHandle = 15,
+    CONSTANT_MethodType = 16,
+    CONSTANT_Dynamic = 17,
+    CONSTANT_InvokeDynamic = 18,
+    CONSTANT_Module = 19,
+    CONSTANT_Package = 20,
+};
+
+enum AccessFlags : uint16_t
+{
+    ACC_PRIVATE = 0x0002,
+    ACC_SUPER = 0x0020,
+};
+
+struct Reader
+{
+    const uint8_t *p;
+    const uint8_t *end;
+
+    void need(size_t n) const
+    {
+        if ((size_t)(end - p) < n)
+            throw SW_RUNTIME_ERROR("Unexpected end of class file");
+    }
+
+    uint8_t u1()
+    {
+        need(1);
+        return *p++;
+    }
+
+    uint16_t u2()
+    {
+        need(2);
+        uint16_t v = (p[0] << 8) | p[1];
+        p += 2;
+        return v;
+    }
+
+    uint32_t u4()
+    {
+        need(4);
+        uint32_t v = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        p += 4;
+        return v;
+    }
+
+    String bytes(size_t n)
+    {
+        need(n);
+        String s((const char *)p, n);
+        p += n;
+        return s;
+    }
+};
+
+struct Constant
+{
+    uint8_t tag = 0;
+    uint16_t ref = 0; // Class, String, MethodType: index of utf8
+    String value; // Utf8 text, numeric value bytes
+};
+
+struct ClassReader
+{
+    std::vector<Constant> pool;
+
+    const String &utf8(uint16_t i) const
+    {
+        if (i >= pool.size() || pool[i].tag != CONSTANT_Utf8)
+            throw SW_RUNTIME_ERROR("Bad constant pool index: " + std::to_string(i));
+        return pool[i].value;
+    }
+
+    const String &className(uint16_t i) const
+    {
+        if (i >= pool.size() || pool[i].tag != CONSTANT_Class)
+            throw SW_RUNTIME_ERROR("Bad class index: " + std::to_string(i));
+        return utf8(pool[i].ref);
+    }
+
+    // value of ConstantValue attribute
+    String constantValue(uint16_t i) const
+    {
+        if (i >= pool.size())
+            throw SW_RUNTIME_ERROR("Bad constant pool index: " + std::to_string(i));
+        auto &c = pool[i];
+        if (c.tag == CONSTANT_String)
+            return "s" + utf8(c.ref);
+        return std::to_string(c.tag) + c.value;
+    }
+
+    void readPool(Reader &r)
+    {
+        auto n = r.u2();
+        pool.resize(n);
+        for (uint16_t i = 1; i < n; i++)
+        {
+            auto &c = pool[i];
+            c.tag = r.u1();
+            switch (c.tag)
+            {
+            case CONSTANT_Utf8:
+                c.value = r.bytes(r.u2());
+                break;
+            case CONSTANT_Integer:
+            case CONSTANT_Float:
+                c.value = r.bytes(4);
+                break;
+            case CONSTANT_Long:
+            case CONSTANT_Double:
+                // takes two entries
+                c.value = r.bytes(8);
+                i++;
+                break;
+            case CONSTANT_Class:
+            case CONSTANT_String:
+            case CONSTANT_MethodType:
+            case CONSTANT_Module:
+            case CONSTANT_Package:
+                c.ref = r.u2();
+                break;
+            case CONSTANT_Fieldref:
+            case CONSTANT_Methodref:
+            case CONSTANT_InterfaceMethodref:
+            case CONSTANT_NameAndType:
+            case CONSTANT_Dynamic:
+            case CONSTANT_InvokeDynamic:
+                r.u4();
+                break;
+            case CONSTANT_MethodHandle:
+                r.u1();
+                r.u2();
+                break;
+            default:
+                throw SW_RUNTIME_ERROR("Unknown constant pool tag: " + std::to_string(c.tag));
+            }
+        }
+    }
+};
+
+// collects class names from descriptors and signatures: Lpkg/Name; or Lpkg/Name<...>;
+void addDescriptorReferences(const String &s, StringSet &refs)
+{
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if (s[i] != 'L')
+            continue;
+        // must follow a descriptor delimiter
+        if (i != 0 && !strchr("()[;<>:+-*^", s[i - 1]))
+            continue;
+        auto e = s.find_first_of(";<", i + 1);
+        if (e == s.npos)
+            return;
+        if (e > i + 1)
+            refs.insert(s.substr(i + 1, e - i - 1));
+        i = e;
+    }
+}
+
+void addClassReference(const String &name, StringSet &refs)
+{
+    // arrays are written as descriptors
+    if (!name.empty() && name[0] == '[')
+        addDescriptorReferences(name, refs);
+    else
+        refs.insert(name);
+}
+
+}
+
+JvmClassInfo readJvmClass(const String &data, bool abi_includes_code)
+{
+    JvmClassInfo info;
+
+    Reader r{ (const uint8_t *)data.data(), (const uint8_t *)data.data() + data.size() };
+    if (r.u4() != 0xCAFEBABE)
+        throw SW_RUNTIME_ERROR("Not a class file");
+    r.u2(); // minor
+    r.u2(); // major
+
+    ClassReader cr;
+    cr.readPool(r);
+
+    // every class mentioned by this one
+    for (auto &c : cr.pool)
+    {
+        if (c.tag == CONSTANT_Class)
+            addClassReference(cr.utf8(c.ref), info.references);
+        else if (c.tag == CONSTANT_Utf8)
+            addDescriptorReferences(c.value, info.references);
+    }
+
+    // abi parts are sorted, so member order does not matter
+    Strings abi;
+    Strings constants;
+
+    auto access = r.u2() & ~ACC_SUPER;
+    info.name = cr.className(r.u2());
+    auto super_index = r.u2();
+    abi.push_back("class " + std::to_string(access) + " " + info.name + " : " + (super_index ? cr.className(super_index) : ""s));
+    auto n_interfaces = r.u2();
+    for (uint16_t i = 0; i < n_interfaces; i++)
+        abi.push_back("implements " + cr.className(r.u2()));
+
+    // returns abi relevant attributes
+    auto read_attributes = [&r, &cr, &info, abi_includes_code](bool member_private, String *constant_value)
+    {
+        Strings attrs;
+        auto n = r.u2();
+        for (uint16_t i = 0; i < n; i++)
+        {
+            auto &name = cr.utf8(r.u2());
+            auto len = r.u4();
+            Reader ar{ r.p, r.p };
+            r.need(len);
+            ar.end = r.p + len;
+            r.p += len;
+
+            if (name == "SourceFile")
+                info.source_file = cr.utf8(ar.u2());
+            if (member_private)
+                continue;
+            if (name == "Signature")
+                attrs.push_back(name + " " + cr.utf8(ar.u2()));
+            else if (name == "Exceptions")
+            {
+                Strings e;
+                auto ne = ar.u2();
+                for (uint16_t j = 0; j < ne; j++)
+                    e.push_back(cr.className(ar.u2()));
+                std::sort(e.begin(), e.end());
+                for (auto &x : e)
+                    attrs.push_back("throws " + x);
+            }
+            else if (name == "ConstantValue" && constant_value)
+                *constant_value = cr.constantValue(ar.u2());
+            else if (name == "Code" && abi_includes_code)
+                attrs.push_back(name + " " + std::to_string(std::hash<String>()(String((const char *)ar.p, len))));
+        }
+        return attrs;
+    };
+
+    auto read_members = [&](const char *kind)
+    {
+        auto n = r.u2();
+        for (uint16_t i = 0; i < n; i++)
+        {
+            auto member_access = r.u2();
+            auto &name = cr.utf8(r.u2());
+            auto &descriptor = cr.utf8(r.u2());
+            bool pvt = member_access & ACC_PRIVATE;
+            String constant_value;
+            auto attrs = read_attributes(pvt, &constant_value);
+            if (pvt)
+                continue;
+            String s = kind + " "s + std::to_string(member_access) + " " + name + " " + descriptor;
+            for (auto &a : attrs)
+                s += " " + a;
+            abi.push_back(s);
+            if (!constant_value.empty())
+                constants.push_back(name + " = " + constant_value);
+        }
+    };
+
+    read_members("field");
+    read_members("method");
+    for (auto &a : read_attributes(false, nullptr))
+        abi.push_back(a);
+
+    std::sort(abi.begin(), abi.end());
+    for (auto &a : abi)
+        hash_combine(info.abi_hash, std::hash<String>()(a));
+    std::sort(constants.begin(), constants.end());
+    for (auto &c : constants)
+        hash_combine(info.constants_hash, std::hash<String>()(c));
+
+    info.references.erase(info.name);
+    return info;
+}
+
+JvmClassInfo readJvmClass(const path &fn, bool abi_includes_code)
+{
+    try
+    {
+        return readJvmClass(read_file(fn), abi_includes_code);
+    }
+    catch (std::exception &e)
+    {
+        throw SW_RUNTIME_ERROR(normalize_path(fn) + ": " + e.what());
+    }
+}
+
+}
@@ -0,0 +1,43 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/filesystem.h>
+
+namespace sw
+{
+
+/// Information from .class file needed for incremental compilation.
+struct JvmClassInfo
+{
+    /// internal name, e.g. org/example/Foo$Bar
+    String name;
+
+    /// SourceFile attribute, file name without directory
+    String source_file;
+
+    /// public ABI: class header, non-private fields and methods with their signatures.
+    /// Does not depend on member order and on private members.
+    size_t abi_hash = 0;
+
+    /// compile time constant values of non-private fields,
+    /// they are inlined into other classes without any trace
+    size_t constants_hash = 0;
+
+    /// all classes this one refers to (internal names)
+    StringSet references;
+};
+
+/// Parses class file contents.
+/// When abi_includes_code is set, bytecode of non-private methods is part of ABI
+/// (languages with inline functions, e.g. Kotlin).
+/// Throws on malformed input.
+JvmClassInfo readJvmClass(const String &data, bool abi_includes_code = false);
+
+JvmClassInfo readJvmClass(const path &fn, bool abi_includes_code = false);
+
+}
@@ -0,0 +1,100 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "make_dependencies.h"
+
+#include <boost/algorithm/string.hpp>
+
+namespace sw
+{
+
+FilesOrdered readMakeDependencies(const String &data)
+{
+    // deps file is a make in form
+    // target: dependencies
+    // deps are split by spaces on several lines with \ at the end of each line except the last one
+    //
+    // example:
+    //
+    // file.o: dep1.cpp dep2.cpp \
+    //  dep1.h dep2.h \
+    //  dep3.h \
+    //  dep4.h
+    //
+    // only the first rule is taken, some tools (rustc) write empty rules for every dependency after it
+    //
+
+    // skip target
+    //  colon must be followed by a space or line end, because on windows target is 'C:/path/to/file: '
+    //                                                                          skip up to this colon ^
+    size_t colon = 0;
+    while ((colon = data.find(':', colon)) != data.npos &&
+        colon + 1 < data.size() && !isspace((unsigned char)data[colon + 1]))
+        colon++;
+    if (colon == data.npos)
+        return {};
+    auto f = data.substr(colon + 1);
+
+    FilesOrdered files;
+
+    enum
+    {
+        EMPTY,
+        FILE,
+    };
+    int state = EMPTY;
+    auto p = f.c_str();
+    auto begin = p;
+    auto rule_ends = [&f](const char *p)
+    {
+        if (*p != '\n')
+            return false;
+        while (p != f.c_str() && (*(p - 1) == '\r'))
+            p--;
+        return p == f.c_str() || *(p - 1) != '\\';
+    };
+    auto add = [&files, &begin](const char *p)
+    {
+        String s(begin, p);
+        boost::replace_all(s, "\\ ", " ");
+        files.push_back(fs::u8path(s));
+    };
+    bool end = false;
+    while (*p && !end)
+    {
+        switch (state)
+        {
+        case EMPTY:
+            if (rule_ends(p))
+            {
+                end = true;
+                break;
+            }
+            if (isspace(*p) || *p == '\\')
+                break;
+            state = FILE;
+            begin = p;
+            break;
+        case FILE:
+            if (!isspace(*p))
+                break;
+            if (*(p - 1) == '\\')
+                break;
+            add(p);
+            state = EMPTY;
+            end = rule_ends(p);
+            break;
+        }
+        p++;
+    }
+    // no new line at the end
+    if (state == FILE)
+        add(p);
+
+    return files;
+}
+
+}
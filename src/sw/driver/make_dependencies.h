@@ -0,0 +1,18 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/filesystem.h>
+
+namespace sw
+{
+
+/// Parses make style deps file written by gcc, clang or rustc (-MD, --emit=dep-info).
+/// Only dependencies of the first rule are returned, escaped spaces are unescaped.
+FilesOrdered readMakeDependencies(const String &data);
+
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "module_dependencies.h"
+
+#include <sw/support/exceptions.h>
+
+#include <nlohmann/json.hpp>
+
+namespace sw
+{
+
+ModuleUnitDependencies readModuleDependencies(const String &data)
+{
+    ModuleUnitDependencies u;
+    auto j = nlohmann::json::parse(data);
+    if (!j.contains("rules") || !j["rules"].is_array())
+        throw SW_RUNTIME_ERROR("bad module dependencies: no rules");
+    for (auto &r : j["rules"])
+    {
+        // interface units and partitions produce bmis, implementation units do not
+        if (r.contains("provides"))
+        {
+            for (auto &p : r["provides"])
+            {
+                if (!u.provides.empty())
+                    throw SW_RUNTIME_ERROR("bad module dependencies: more than one module is provided");
+                u.provides = p["logical-name"].get<String>();
+            }
+        }
+        if (r.contains("requires"))
+        {
+            for (auto &p : r["requires"])
+            {
+                // header units are not supported
+                if (p.contains("lookup-method") && p["lookup-method"] != "by-name")
+                    continue;
+                u.imports.insert(p["logical-name"].get<String>());
+            }
+        }
+    }
+    return u;
+}
+
+ModuleUnitDependencies readModuleDependencies(const path &fn)
+{
+    try
+    {
+        return readModuleDependencies(read_file(fn));
+    }
+    catch (std::exception &e)
+    {
+        throw SW_RUNTIME_ERROR(normalize_path(fn) + ": " + e.what());
+    }
+}
+
+}
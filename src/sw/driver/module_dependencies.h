@@ -0,0 +1,30 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/filesystem.h>
+
+namespace sw
+{
+
+/// C++20 named modules of one translation unit.
+struct ModuleUnitDependencies
+{
+    /// module name for interface units and partitions, empty otherwise
+    String provides;
+
+    /// imported modules and partitions, header units are skipped
+    StringSet imports;
+};
+
+/// Parses P1689 dependencies written by a compiler or a scanner (https://wg21.link/p1689r5).
+/// Throws on malformed input.
+ModuleUnitDependencies readModuleDependencies(const String &data);
+
+ModuleUnitDependencies readModuleDependencies(const path &fn);
+
+}
@@ -172,6 +172,25 @@ DependencyData::DependencyData(const UnresolvedPackage &p)
     package = p;
 }
 
+TargetSettings &DependencyData::getSettings()
+{
+    frozen_settings.reset();
+    return settings;
+}
+
+const FrozenTargetSettings &DependencyData::getFrozenSettings() const
+{
+    if (!frozen_settings)
+        frozen_settings = settings;
+    return *frozen_settings;
+}
+
+void DependencyData::setSettings(const TargetSettings &s)
+{
+    settings = s;
+    frozen_settings.reset();
+}
+
 /*Dependency &Dependency::operator=(const Target &t)
 {
     setTarget(t);
@@ -540,7 +559,7 @@ void NativeLinkerOptions::add(const DependencyPtr &t)
     deps.push_back(t);
 
     if (auto t2 = dynamic_cast<Target *>(this))
-        t->settings.mergeMissing(t2->getExportOptions()); // add only missing fields!
+        t->getSettings().mergeMissing(t2->getExportOptions()); // add only missing fields!
 }
 
 void NativeLinkerOptions::remove(const DependencyPtr &t)
@@ -555,7 +574,7 @@ void NativeLinkerOptions::remove(const DependencyPtr &t)
     deps.push_back(t);
 
     if (auto t2 = dynamic_cast<Target *>(this))
-        t->settings.mergeMissing(t2->getExportOptions()); // add only missing fields!
+        t->getSettings().mergeMissing(t2->getExportOptions()); // add only missing fields!
 }
 
 void NativeLinkerOptions::add(const UnresolvedPackage &t)
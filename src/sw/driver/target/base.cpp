@@ -831,7 +831,7 @@ DependencyPtr Target::addDummyDependency(const DependencyPtr &t)
     DummyDependencies.push_back(t);
 
     auto &hs = getHostSettings();
-    auto &ds = DummyDependencies.back()->settings;
+    auto &ds = DummyDependencies.back()->getSettings();
     ds.mergeMissing(hs);
     return t;
 }
@@ -845,8 +845,7 @@ void Target::addSourceDependency(const DependencyPtr &t)
 {
     SourceDependencies.push_back(t);
 
-    auto &ds = SourceDependencies.back()->settings;
-    ds = {}; // accept everything
+    SourceDependencies.back()->setSettings({}); // accept everything
 }
 
 void Target::addSourceDependency(const Target &t)
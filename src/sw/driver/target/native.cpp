@@ -11,12 +11,16 @@
 #include "../frontend/cppan/project.h"
 #include "../functions.h"
 #include "../build.h"
+#include "../configure_file.h"
+#include "../module_dependencies.h"
 #include "../command.h"
 
+#include <sw/builder/execution_plan.h>
 #include <sw/builder/jumppad.h>
 #include <sw/core/sw_context.h>
 #include <sw/manager/storage.h>
 #include <sw/manager/yaml.h>
+#include <sw/support/hash.h>
 
 #include <boost/algorithm/string.hpp>
 #include <nlohmann/json.hpp>
@@ -498,6 +502,14 @@ std::shared_ptr<NativeLinker> NativeCompiledTarget::activateLinker(const TargetS
         c = C;
         c->Type = LinkerType::GNU;
         C->Prefix = getBuildSettings().TargetOS.getLibraryPrefix();
+
+        // objects are not copied into thin archives,
+        // such archives are valid only while objects are in place
+        if (getBuildSettings().Native.FastLink && getBuildSettings().TargetOS.is(OSType::Linux))
+        {
+            C->Options = false;
+            C->ThinOptions = true;
+        }
     }
     else if (
         id.ppath == "org.gnu.gcc" ||
@@ -525,6 +537,25 @@ std::shared_ptr<NativeLinker> NativeCompiledTarget::activateLinker(const TargetS
             cmd->push_back(getBuildSettings().getTargetTriplet());
         }
         // TODO: find -fuse-ld option and set c->Type accordingly
+
+        if (getBuildSettings().Native.FastLink && getBuildSettings().TargetOS.is(OSType::Linux))
+        {
+            // take the fastest detected linker supported by compiler driver
+            auto has_linker = [&cld, &oss](const String &ppath)
+            {
+                return !!cld.find(UnresolvedPackage(ppath), oss);
+            };
+            bool gcc = id.ppath == "org.gnu.gcc" || id.ppath == "org.gnu.gpp";
+            auto v = i->getPackage().getVersion();
+            if (has_linker("com.github.rui314.mold") && (!gcc || v >= Version(12, 1)))
+                C->UseLinker = "mold";
+            else if (has_linker("org.LLVM.ld") && (!gcc || v >= Version(9)))
+                C->UseLinker = "lld";
+
+            // index is built from split dwarf, bfd ld cannot do this
+            if (C->UseLinker)
+                C->GdbIndex = true;
+        }
     }
     else if (id.ppath == "org.gnu.gcc.ld")
     {
@@ -1141,6 +1172,47 @@ NativeLinker *NativeCompiledTarget::getSelectedTool() const
     throw SW_RUNTIME_ERROR("No tool selected");
 }
 
+String NativeCompiledTarget::getPrecompiledHeaderKey(const String &header) const
+{
+    // everything that affects pch contents, but not this target identity
+    String s = header;
+    s += "\n" + getSettings().getHash();
+    s += "\n" + std::to_string((int)CPPVersion) + " " + std::to_string((int)CVersion);
+    s += "\n" + std::to_string(ExportAllSymbols && getSelectedTool() == Linker.get());
+
+    const NativeCompilerOptions &o = *this;
+    builder::Command c;
+    o.addDefinitions(c);
+    o.addCompileOptions(c);
+    for (auto &a : c.arguments)
+        s += "\n" + a->toString();
+
+    // declared and generated headers of this target
+    FilesOrdered headers;
+    for (auto &[p, f] : *this)
+    {
+        if (getCppHeaderFileExtensions().count(p.extension().string()))
+            headers.push_back(p);
+    }
+
+    for (auto &d : o.gatherIncludeDirectories())
+    {
+        // own binary dirs are on every target include path,
+        // they matter only when this target puts headers there
+        if ((d == BinaryDir || d == BinaryPrivateDir) &&
+            std::none_of(headers.begin(), headers.end(), [&d](const auto &h) { return is_under_root(h, d); }))
+            continue;
+        s += "\n" + normalize_path(d);
+    }
+    for (auto &h : headers)
+    {
+        // generated headers are not on disk yet
+        if (File(h, getFs()).isGenerated())
+            s += "\n" + normalize_path(h);
+    }
+    return shorten_hash(blake2b_512(s), 12);
+}
+
 void NativeCompiledTarget::createPrecompiledHeader()
 {
     // disabled with PP
@@ -1154,9 +1226,6 @@ void NativeCompiledTarget::createPrecompiledHeader()
     if (pch.name.empty())
         pch.name = "sw_pch";
 
-    if (pch.dir.empty())
-        pch.dir = BinaryDir.parent_path() / "pch";
-
     if (pch.files.empty())
         pch.files = files;
 
@@ -1168,13 +1237,28 @@ void NativeCompiledTarget::createPrecompiledHeader()
         else
             h += "#include \"" + normalize_path(f) + "\"\n";
     }
-    pch.header = pch.get_base_pch_path() += ".h";
-    write_file_if_different(pch.header, h);
-    File(pch.header, getFs()).setGenerated(true); // prevents resolving issues
 
-    pch.source = pch.get_base_pch_path() += ".cpp"; // msvc
-    write_file_if_different(pch.source, "#include \"" + normalize_path(pch.header) + "\"");
-    File(pch.source, getFs()).setGenerated(true); // prevents resolving issues
+    // targets with the same headers and compile settings get the same pch dir,
+    // pch is built once for them (see getCommands1())
+    if (pch.dir.empty())
+    {
+        pch.dir = getMainBuild().getBuildDirectory() / "pch" / getPrecompiledHeaderKey(h);
+        pch.shared = true;
+    }
+
+    {
+        // other targets may write the same files
+        static std::mutex m;
+        std::unique_lock lk(m);
+
+        pch.header = pch.get_base_pch_path() += ".h";
+        write_file_if_different(pch.header, h);
+        File(pch.header, getFs()).setGenerated(true); // prevents resolving issues
+
+        pch.source = pch.get_base_pch_path() += ".cpp"; // msvc
+        write_file_if_different(pch.source, "#include \"" + normalize_path(pch.header) + "\"");
+        File(pch.source, getFs()).setGenerated(true); // prevents resolving issues
+    }
 
     //
     if (pch.pch.empty())
@@ -1344,6 +1428,239 @@ Commands NativeCompiledTarget::getGeneratedCommands() const
     return generated;
 }
 
+// partitions are named m:part
+static String getModuleFilename(String name)
+{
+    std::replace(name.begin(), name.end(), ':', '-');
+    return name;
+}
+
+static path getClangScanDeps(const path &clang)
+{
+    // clang++-18 -> clang-scan-deps-18
+    auto fn = clang.stem().u8string();
+    auto p = fn.find('-');
+    auto suffix = p == fn.npos ? ""s : fn.substr(p);
+    auto sd = clang.parent_path() / ("clang-scan-deps" + suffix);
+    sd += clang.extension();
+    if (fs::exists(sd))
+        return sd;
+    sd = resolveExecutable("clang-scan-deps" + suffix);
+    if (sd.empty())
+        throw SW_RUNTIME_ERROR("clang-scan-deps is not found near " + normalize_path(clang));
+    return sd;
+}
+
+const detail::ModuleDependencies &NativeCompiledTarget::scanModules() const
+{
+    if (module_dependencies)
+        return *module_dependencies;
+    auto &md = module_dependencies.emplace();
+    if (!UseModules || DryRun || getCompilerType() == CompilerType::MSVC)
+        return md;
+    // commands are only enumerated by vs generator, do not run scanner for every source
+    if (getMainBuild().getSettings()["commands_only"] == "true")
+        return md;
+
+    auto dir = BinaryPrivateDir / "modules";
+    auto bmi_dir = BinaryPrivateDir / "bmi";
+    fs::create_directories(dir);
+    fs::create_directories(bmi_dir);
+
+    // headers may be generated, so generators run before scanning;
+    // they are scheduled again in the main plan where they are up to date,
+    // but always outdated commands would run twice, so they are left to the main plan
+    Commands generated;
+    for (auto &c : getGeneratedCommands())
+    {
+        if (!c->command_storage)
+            c->command_storage = getCommandStorage(); // not a dry run here
+        if (!c->always)
+            generated.insert(c);
+    }
+
+    // one scan command per c++ source, unchanged sources are not rescanned
+    Commands scans;
+    std::unordered_map<path, path> ddis;
+    bool version_checked = false;
+    for (auto &f : gatherSourceFiles())
+    {
+        auto &exts = getCppSourceFileExtensions();
+        if (f->BuildAs != NativeSourceFile::CPP && exts.find(f->file.extension().string()) == exts.end())
+            continue;
+        auto ddi = dir / (SourceFile::getObjectFilename(*this, f->file) += ".ddi");
+
+        std::shared_ptr<builder::Command> cmd;
+        if (auto c = f->compiler->as<GNUCompiler*>())
+        {
+            if (!version_checked && getVersion(getMainBuild().getContext(), c->file) < Version(14))
+                throw SW_RUNTIME_ERROR(getPackage().toString() + ": modules require gcc 14 or newer for dependency scanning");
+            version_checked = true;
+
+            // gcc writes p1689 while preprocessing
+            auto C = std::static_pointer_cast<GNUCompiler>(c->clone());
+            C->CompileWithoutLinking = false;
+            C->PreprocessOnly = true;
+            C->ModulesTs = true;
+            C->DepsFormat = "p1689r5";
+            C->DepsFile = ddi;
+            C->DepsTarget = f->output;
+            C->OutputFile = path(ddi) += ".i";
+            cmd = C->getCommand(*this);
+        }
+        else if (auto c = f->compiler->as<ClangCompiler*>())
+        {
+            // clang-scan-deps takes the whole compile command line
+            auto C = std::static_pointer_cast<ClangCompiler>(c->clone());
+            C->OutputFile = path(ddi) += ".o";
+            C->DependenciesFile = path(ddi) += ".d";
+            auto cc = C->getCommand(*this);
+            cc->prepare();
+
+            auto sc = std::make_shared<driver::GNUCommand>(getMainBuild().getContext());
+            sc->setProgram(getClangScanDeps(c->file));
+            sc->deps_file = C->DependenciesFile();
+            sc->arguments.push_back("-format=p1689");
+            sc->arguments.push_back("--");
+            sc->arguments.push_back(cc->getProgram());
+            for (auto &a : cc->arguments)
+                sc->arguments.push_back(a->toString());
+            sc->addInput(f->file);
+            sc->redirectStdout(ddi);
+            cmd = sc;
+        }
+        else
+            continue;
+
+        cmd->name = "scan: " + normalize_path(f->file);
+        cmd->command_storage = getCommandStorage();
+        if (!cmd->command_storage)
+            cmd->always = true;
+        cmd->dependencies.insert(generated.begin(), generated.end());
+        scans.insert(cmd);
+        ddis[f->file] = ddi;
+    }
+    if (scans.empty())
+        return md;
+
+    // scan results are needed before compile commands are created,
+    // so scanning runs as a separate plan;
+    // commands are created on the main thread, so the plan may use the shared executor
+    std::vector<std::pair<builder::Command *, std::unordered_set<CommandNode::SPtr>>> used;
+    {
+        auto ep = ExecutionPlan::create(scans);
+        if (!ep)
+            throw SW_RUNTIME_ERROR(getPackage().toString() + ": cannot create module scan plan");
+        ep.execute(getExecutor());
+
+        // plan clears dependencies on destruction, keep them for the main plan
+        for (auto &c : ep.getCommands())
+        {
+            auto c1 = static_cast<builder::Command *>(c);
+            if (scans.find(std::static_pointer_cast<builder::Command>(c1->shared_from_this())) == scans.end())
+                used.emplace_back(c1, c1->dependencies);
+        }
+    }
+    for (auto &[c, deps] : used)
+    {
+        c->dependencies = std::move(deps);
+        c->resetExecution();
+    }
+
+    auto bmi_ext = getCompilerType() == CompilerType::GNU ? ".gcm" : ".pcm";
+    for (auto &[f, ddi] : ddis)
+    {
+        auto u = readModuleDependencies(ddi);
+        if (!u.provides.empty())
+        {
+            auto &i = md.interfaces[u.provides];
+            if (!i.bmi.empty())
+                throw SW_RUNTIME_ERROR(getPackage().toString() + ": module " + u.provides + " is provided by more than one source");
+            i.bmi = bmi_dir / (getModuleFilename(u.provides) + bmi_ext);
+            i.imports = u.imports;
+        }
+        md.units[f] = std::move(u);
+    }
+    return md;
+}
+
+void NativeCompiledTarget::addModuleDependencies() const
+{
+    auto &md = scanModules();
+
+    // modules visible to this target
+    std::map<String, const detail::ModuleDependencies::Interface *> modules;
+    for (auto &d : getAllDependencies())
+    {
+        if (auto dt = d->getTarget().template as<const NativeCompiledTarget *>(); dt && dt->UseModules)
+        {
+            for (auto &[n, i] : dt->scanModules().interfaces)
+                modules.emplace(n, &i);
+        }
+    }
+    for (auto &[n, i] : md.interfaces)
+        modules[n] = &i;
+
+    // clang needs bmis of all transitively imported modules
+    auto gather_imports = [&modules](const StringSet &imports)
+    {
+        StringSet all;
+        Strings q(imports.begin(), imports.end());
+        while (!q.empty())
+        {
+            auto n = q.back();
+            q.pop_back();
+            auto i = modules.find(n);
+            // std and other unknown modules are left to the compiler
+            if (i == modules.end() || !all.insert(n).second)
+                continue;
+            q.insert(q.end(), i->second->imports.begin(), i->second->imports.end());
+        }
+        return all;
+    };
+
+    path mapper;
+    if (getCompilerType() == CompilerType::GNU)
+    {
+        String s;
+        for (auto &[n, i] : modules)
+            s += n + " " + normalize_path(i->bmi) + "\n";
+        mapper = BinaryPrivateDir / "modules.map";
+        write_file_if_different(mapper, s); // do not trigger rebuilds
+    }
+
+    // producers write bmis, importers take them as inputs,
+    // so importers are rebuilt only when an interface changes
+    for (auto &f : gatherSourceFiles())
+    {
+        auto u = md.units.find(f->file);
+        if (u == md.units.end())
+            continue;
+        auto bmi = u->second.provides.empty() ? path() : md.interfaces.at(u->second.provides).bmi;
+        auto imports = gather_imports(u->second.imports);
+        auto cmd = f->compiler->createCommand(getMainBuild().getContext());
+        if (auto c = f->compiler->as<GNUCompiler*>())
+        {
+            c->ModulesTs = true;
+            c->ModuleMapper = mapper;
+            if (!bmi.empty())
+                cmd->addOutput(bmi);
+        }
+        else if (auto c = f->compiler->as<ClangCompiler*>())
+        {
+            if (!bmi.empty())
+            {
+                c->Language = "c++-module";
+                c->ModuleOutput = bmi;
+            }
+            for (auto &n : imports)
+                c->ModuleFiles()[n] = normalize_path(modules[n]->bmi);
+        }
+        for (auto &n : imports)
+            cmd->addInput(modules[n]->bmi);
+    }
+}
+
 Commands NativeCompiledTarget::getCommands1() const
 {
     //if (getSolution().skipTarget(Scope))
@@ -1408,12 +1725,42 @@ Commands NativeCompiledTarget::getCommands1() const
             cmds.insert(c);
         };
 
+        if (UseModules)
+            addModuleDependencies();
+
         for (auto &f : gatherSourceFiles())
         {
             auto c = f->getCommand(*this);
             prepare_command(f, c);
         }
 
+        // the first target creating shared pch gives its command to others
+        if (pch.shared)
+        {
+            static std::mutex m;
+            static std::unordered_map<path, std::weak_ptr<builder::Command>> shared_pchs;
+
+            auto i = std::find_if(cmds.begin(), cmds.end(), [this](const auto &c)
+            {
+                return c->outputs.find(pch.pch) != c->outputs.end();
+            });
+            if (i != cmds.end())
+            {
+                std::unique_lock lk(m);
+                auto &w = shared_pchs[pch.pch];
+                if (auto c = w.lock(); c && c != *i)
+                {
+                    cmds.erase(i);
+                    cmds.insert(c);
+                    // our users must depend on the shared command
+                    for (auto &o : c->outputs)
+                        File(o, getFs()).setGenerator(c, true);
+                }
+                else
+                    w = *i;
+            }
+        }
+
         for (auto &f : ::sw::gatherSourceFiles<RcToolSourceFile>(*this))
         {
             auto c = f->getCommand(*this);
@@ -1890,7 +2237,9 @@ static auto createDependency(const DependencyPtr &d, InheritanceType i, const Ta
     TargetDependency td;
     td.dep = d;
     td.inhtype = i;
-    td.dep->settings.mergeMissing(t.getExportOptions());
+    // unchanged frozen settings were already merged when dependency was added
+    if (!td.dep->hasFrozenSettings())
+        td.dep->getSettings().mergeMissing(t.getExportOptions());
     /*auto s = td.dep->settings;
     td.dep->settings.mergeAndAssign(t.getExportOptions());
     td.dep->settings.mergeAndAssign(s);*/
@@ -2186,8 +2535,17 @@ void NativeCompiledTarget::prepare_pass1()
 
     if (UseModules)
     {
-        if (getCompilerType() != CompilerType::MSVC)
-            throw SW_RUNTIME_ERROR("Currently modules are implemented for MSVC only");
+        // gcc and clang modules are wired by scanModules()
+        switch (getCompilerType())
+        {
+        case CompilerType::MSVC:
+        case CompilerType::GNU:
+        case CompilerType::Clang:
+        case CompilerType::AppleClang:
+            break;
+        default:
+            throw SW_RUNTIME_ERROR("Currently modules are implemented for MSVC, GCC and Clang only");
+        }
         CPPVersion = CPPLanguageStandard::CPP2a;
     }
 
@@ -2285,7 +2643,7 @@ void NativeCompiledTarget::prepare_pass2()
     // resolve deps
     for (auto &d : getActiveDependencies())
     {
-        auto t = getMainBuild().getTargets().find(d.dep->getPackage(), d.dep->settings);
+        auto t = getMainBuild().getTargets().find(d.dep->getPackage(), d.dep->getFrozenSettings());
         if (!t)
             throw SW_RUNTIME_ERROR("No such target: " + d.dep->getPackage().toString());
         d.dep->setTarget(*t);
@@ -2437,7 +2795,7 @@ void NativeCompiledTarget::prepare_pass3()
                             {
                                 // construct
                                 Dependency d2(d3->getTarget());
-                                d2.settings = d3->getSettings();
+                                d2.setSettings(d3->getSettings());
                                 d2.setTarget(d3->getTarget());
                                 d2.IncludeDirectoriesOnly = d3->getSettings()["include_directories_only"] == "true";
 
@@ -2711,6 +3069,10 @@ void NativeCompiledTarget::prepare_pass5()
             else
                 c->CStandard = CVersion;
 
+            // linker does not need to read and copy debug info
+            if (getBuildSettings().Native.FastLink && getBuildSettings().TargetOS.is(OSType::Linux) && c->GenerateDebugInformation())
+                c->SplitDwarf = true;
+
             if (ExportAllSymbols && getSelectedTool() == Linker.get())
                 c->VisibilityHidden = false;
         };
@@ -3151,10 +3513,14 @@ void NativeCompiledTarget::prepare_pass7()
     {
         auto ll = [this](auto &l, int what)
         {
-            std::unordered_set<const NativeCompiledTarget*> targets;
-            Files added;
-            added.insert(l.begin(), l.end());
-            gatherStaticLinkLibraries(l, added, targets, what);
+            std::unordered_set<const NativeCompiledTarget*> visiting;
+            bool cut = false;
+            Files added(l.begin(), l.end());
+            for (auto &p : *gatherStaticLinkLibraries(what, visiting, cut))
+            {
+                if (added.insert(p).second)
+                    l.push_back(p);
+            }
         };
 
         ll(LinkLibraries, E_link_libraries);
@@ -3356,63 +3722,62 @@ void NativeCompiledTarget::processCircular(Files &obj)
     obj.insert(exp);
 }
 
-template <class T>
-void NativeCompiledTarget::gatherStaticLinkLibraries(
-    T &ll, Files &added, std::unordered_set<const NativeCompiledTarget*> &targets, int what) const
+// guards static_link_libraries of all targets, targets are prepared in parallel
+static std::mutex static_link_libraries_mutex;
+
+NativeCompiledTarget::StaticLinkLibraries NativeCompiledTarget::gatherStaticLinkLibraries(
+    int what, std::unordered_set<const NativeCompiledTarget*> &visiting, bool &cut) const
 {
-    if (!targets.insert(this).second)
-        return;
+    {
+        std::unique_lock lk(static_link_libraries_mutex);
+        if (static_link_libraries[what])
+            return static_link_libraries[what];
+    }
+
+    // in link order, every item once
+    auto ll = std::make_shared<FilesOrdered>();
+    std::unordered_set<path> added;
+    auto add = [&ll, &added](const path &p)
+    {
+        if (added.insert(p).second)
+            ll->push_back(p);
+    };
+
+    // circular deps are cut, such results are not saved
+    visiting.insert(this);
+    auto add_target = [this, &add, &visiting, &cut, what](const NativeCompiledTarget &dt)
+    {
+        if (visiting.find(&dt) != visiting.end())
+        {
+            cut = true;
+            return;
+        }
+        for (auto &l : *dt.gatherStaticLinkLibraries(what, visiting, cut))
+            add(l);
+    };
+
     // switch to getActiveDeps()?
     for (auto &d : getAllDependencies())
     {
         if (d->IncludeDirectoriesOnly)
             continue;
 
-        auto add_native = [&added, &ll](auto &dt, const path &base, auto &a, int what)
+        auto add_native = [&add](auto &dt, const path &base, auto &a, int what)
         {
-            if (added.find(base) == added.end() && what == E_link_libraries)
-            {
-                if (!*dt->HeaderOnly)
-                    ll.push_back(base);
-                for (auto &l : a)
-                {
-                    ll.push_back(l); // also link libs
-                }
-            }
-            else
-            {
-                // we added output file but not its system libs
-                for (auto &l : a)
-                {
-                    if (std::find(ll.begin(), ll.end(), l) == ll.end())
-                        ll.push_back(l);
-                }
-            }
+            if (what == E_link_libraries && !*dt->HeaderOnly)
+                add(base);
+            // also link libs
+            for (auto &l : a)
+                add(l);
         };
 
-        auto add_predefined = [&added, &ll](auto &s, auto &dt, const path &base, auto &a, int what)
+        auto add_predefined = [&add](auto &s, auto &dt, const path &base, auto &a, int what)
         {
-            if (added.find(base) == added.end() && what == E_link_libraries)
-            {
-                if (s["header_only"] != "true")
-                    ll.push_back(base);
-                // also link libs
-                for (auto &l : a)
-                {
-                    ll.push_back(std::get<String>(l));
-                }
-            }
-            else
-            {
-                // we added output file but not its system libs
-                for (auto &l : a)
-                {
-                    if (std::find(ll.begin(), ll.end(), std::get<String>(l)) == ll.end())
-                    {
-                        ll.push_back(std::get<String>(l));
-                    }
-                }
-            }
+            if (what == E_link_libraries && s["header_only"] != "true")
+                add(base);
+            // also link libs
+            for (auto &l : a)
+                add(std::get<String>(l));
         };
 
         // here we must gather all static (and header only?) lib deps in recursive manner
@@ -3460,7 +3825,7 @@ void NativeCompiledTarget::gatherStaticLinkLibraries(
                         add_native(dt2, dt2->getImportLibrary(), dt2->Frameworks, what);
                         break;
                     }
-                    dt2->gatherStaticLinkLibraries(ll, added, targets, what);
+                    add_target(*dt2);
                 }
             }
         }
@@ -3512,7 +3877,7 @@ void NativeCompiledTarget::gatherStaticLinkLibraries(
                             add_native(dt2, dt2->getImportLibrary(), dt2->Frameworks, what);
                             break;
                         }
-                        dt2->gatherStaticLinkLibraries(ll, added, targets, what);
+                        add_target(*dt2);
                     }
                     else if (auto dt2 = d2->getTarget().template as<const PredefinedTarget *>())
                     {
@@ -3532,7 +3897,6 @@ void NativeCompiledTarget::gatherStaticLinkLibraries(
                                 break;
                             }
                         }
-                        //dt2->gatherStaticLinkLibraries(ll, added, targets, what);
                     }
                     else
                         throw SW_RUNTIME_ERROR("missing predefined target code");
@@ -3542,6 +3906,15 @@ void NativeCompiledTarget::gatherStaticLinkLibraries(
         else
             throw SW_RUNTIME_ERROR("missing predefined target code");
     }
+    visiting.erase(this);
+
+    // only complete sets are saved, same set may be computed by several threads at once
+    if (cut && !visiting.empty())
+        return ll;
+    std::unique_lock lk(static_link_libraries_mutex);
+    if (!static_link_libraries[what])
+        static_link_libraries[what] = ll;
+    return static_link_libraries[what];
 }
 
 void NativeCompiledTarget::gatherRpathLinkDirectories(
@@ -3715,17 +4088,6 @@ void NativeCompiledTarget::configureFile(path from, path to, ConfigureFlags flag
 
 void NativeCompiledTarget::configureFile1(const path &from, const path &to, ConfigureFlags flags)
 {
-    static const std::regex cmDefineRegex(R"xxx(#cmakedefine[ \t]+([A-Za-z_0-9]*)([^\r\n]*?)[\r\n])xxx");
-    static const std::regex cmDefine01Regex(R"xxx(#cmakedefine01[ \t]+([A-Za-z_0-9]*)[^\r\n]*?[\r\n])xxx");
-    static const std::regex mesonDefine(R"xxx(#mesondefine[ \t]+([A-Za-z_0-9]*)[^\r\n]*?[\r\n])xxx");
-    static const std::regex undefDefine(R"xxx(#undef[ \t]+([A-Za-z_0-9]*)[^\r\n]*?[\r\n])xxx");
-    static const std::regex cmAtVarRegex("@([A-Za-z_0-9/.+-]+)@");
-    static const std::regex cmNamedCurly("\\$\\{([A-Za-z0-9/_.+-]+)\\}");
-
-    static const StringSet offValues{
-        "", "0", //"OFF", "NO", "FALSE", "N", "IGNORE",
-    };
-
     configure_files.insert(from);
 
     auto s = read_file(from);
@@ -3757,91 +4119,32 @@ void NativeCompiledTarget::configureFile1(const path &from, const path &to, Conf
         return {};
     };
 
-    std::smatch m;
-
-    // @vars@
-    while (std::regex_search(s, m, cmAtVarRegex) ||
-        std::regex_search(s, m, cmNamedCurly))
-    {
-        auto repl = find_repl(m[1].str());
-        if (!repl)
-        {
-            s = m.prefix().str() + m.suffix().str();
-            // make additional log level for this
-            //LOG_TRACE(logger, "configure @@ or ${} " << m[1].str() << ": replacement not found");
-            continue;
-        }
-        s = m.prefix().str() + *repl + m.suffix().str();
-    }
+    // template is parsed once, results are memoized by values of used variables
+    auto t = ConfigureFileTemplate::get(s, (int)flags & (int)ConfigureFlags::EnableUndefReplacements);
+    ConfigureFileTemplate::Values values;
+    values.reserve(t->getVariables().size());
+    for (auto &v : t->getVariables())
+        values.push_back(find_repl(v));
+    s = t->configure(values);
 
-    // #mesondefine
-    while (std::regex_search(s, m, mesonDefine))
-    {
-        auto repl = find_repl(m[1].str());
-        if (!repl)
-        {
-            s = m.prefix().str() + "/* #undef " + m[1].str() + " */\n" + m.suffix().str();
-            // make additional log level for this
-            //LOG_TRACE(logger, "configure #mesondefine " << m[1].str() << ": replacement not found");
-            continue;
-        }
-        s = m.prefix().str() + "#define " + m[1].str() + " " + *repl + "\n" + m.suffix().str();
-    }
-
-    // #undef
-    if ((int)flags & (int)ConfigureFlags::EnableUndefReplacements)
-    {
-        while (std::regex_search(s, m, undefDefine))
-        {
-            auto repl = find_repl(m[1].str());
-            if (!repl)
-            {
-                s = m.prefix().str() + m.suffix().str();
-                // make additional log level for this
-                //LOG_TRACE(logger, "configure #undef " << m[1].str() << ": replacement not found");
-                continue;
-            }
-            if (offValues.find(boost::to_upper_copy(*repl)) != offValues.end())
-                // space to prevent loops
-                s = m.prefix().str() + "/* # undef " + m[1].str() + " */\n" + m.suffix().str();
-            else
-                s = m.prefix().str() + "#define " + m[1].str() + " " + *repl + "\n" + m.suffix().str();
-        }
-    }
-
-    // #cmakedefine
-    while (std::regex_search(s, m, cmDefineRegex))
-    {
-        auto repl = find_repl(m[1].str());
-        if (!repl)
-        {
-            // make additional log level for this
-            //LOG_TRACE(logger, "configure #cmakedefine " << m[1].str() << ": replacement not found");
-            repl = {};
-        }
-        if (offValues.find(boost::to_upper_copy(*repl)) != offValues.end())
-            s = m.prefix().str() + "/* #undef " + m[1].str() + m[2].str() + " */\n" + m.suffix().str();
-        else
-            s = m.prefix().str() + "#define " + m[1].str() + m[2].str() + "\n" + m.suffix().str();
-    }
-
-    // #cmakedefine01
-    while (std::regex_search(s, m, cmDefine01Regex))
+    // skip writing when the same file was already written with the same content
+    static std::mutex m;
+    static std::unordered_map<path, size_t> written;
+    auto h = std::hash<String>()(s);
     {
-        auto repl = find_repl(m[1].str());
-        if (!repl)
+        std::unique_lock lk(m);
+        auto i = written.find(to);
+        if (i != written.end() && i->second == h && fs::exists(to))
         {
-            // make additional log level for this
-            //LOG_TRACE(logger, "configure #cmakedefine01 " << m[1].str() << ": replacement not found");
-            repl = {};
+            addFileSilently(to);
+            return;
         }
-        if (offValues.find(boost::to_upper_copy(*repl)) != offValues.end())
-            s = m.prefix().str() + "#define " + m[1].str() + " 0" + "\n" + m.suffix().str();
-        else
-            s = m.prefix().str() + "#define " + m[1].str() + " 1" + "\n" + m.suffix().str();
     }
 
     writeFileOnce(to, s);
+
+    std::unique_lock lk(m);
+    written[to] = h;
 }
 
 CheckSet &NativeCompiledTarget::getChecks(const String &name)
@@ -188,8 +188,9 @@ private:
 
     Commands getGeneratedCommands() const;
     void resolvePostponedSourceFiles();
-    template <class T>
-    void gatherStaticLinkLibraries(T &ll, Files &added, std::unordered_set<const NativeCompiledTarget*> &targets, int type) const;
+    using StaticLinkLibraries = std::shared_ptr<const FilesOrdered>;
+    mutable std::array<StaticLinkLibraries, 3> static_link_libraries; // memoized by gatherStaticLinkLibraries()
+    StaticLinkLibraries gatherStaticLinkLibraries(int what, std::unordered_set<const NativeCompiledTarget*> &visiting, bool &cut) const;
     void gatherRpathLinkDirectories(Files &added, int round) const;
     FilesOrdered gatherLinkDirectories() const;
     FilesOrdered gatherLinkLibraries() const;
@@ -201,9 +202,14 @@ private:
     const TargetSettings &getInterfaceSettings() const override;
 
     FilesOrdered gatherPrecompiledHeaders() const;
+    String getPrecompiledHeaderKey(const String &header) const;
     void createPrecompiledHeader();
     void addPrecompiledHeader();
 
+    mutable std::optional<detail::ModuleDependencies> module_dependencies; // memoized by scanModules()
+    const detail::ModuleDependencies &scanModules() const;
+    void addModuleDependencies() const;
+
     bool libstdcppset = false;
     void findCompiler();
     void activateCompiler(const TargetSetting &s, const StringSet &exts);
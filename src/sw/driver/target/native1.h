@@ -7,6 +7,7 @@
 #pragma once
 
 #include "base.h"
+#include "../module_dependencies.h"
 
 namespace sw
 {
@@ -37,6 +38,7 @@ struct PrecompiledHeader
     path obj; // obj file (msvc)
     path pdb; // pdb file (msvc)
     path pch; // file itself
+    bool shared = false; // pch command may be used by other targets with the same key
 
     path get_base_pch_path() const
     {
@@ -44,6 +46,21 @@ struct PrecompiledHeader
     }
 };
 
+/// C++20 named modules of a target, read from P1689 scan results
+struct ModuleDependencies
+{
+    using Unit = ModuleUnitDependencies;
+
+    struct Interface
+    {
+        path bmi;
+        StringSet imports;
+    };
+
+    std::unordered_map<path, Unit> units; // by source file
+    std::map<String, Interface> interfaces; // by module name
+};
+
 }
 
 enum class ConfigureFlags
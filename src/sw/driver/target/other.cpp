@@ -5,6 +5,10 @@
 #include <sw/core/sw_context.h>
 #include <sw/core/program/detect.h>
 #include <sw/manager/storage.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <sstream>
 
 namespace sw
 {
@@ -156,19 +160,93 @@ bool RustTarget::init()
     if (!compiler)
         throw SW_RUNTIME_ERROR("No Rust compiler found");
 
-    compiler->Extension = getBuildSettings().TargetOS.getExecutableExtension();
-    compiler->setOutputFile(getBaseOutputFileName(*this, {}, "bin"));
+    // crate name is used by dependents in --extern and in library file names
+    auto crate = getPackage().getPath().back();
+    for (auto &c : crate)
+    {
+        if (!isalnum((unsigned char)c))
+            c = '_';
+    }
+    compiler->CrateName = crate;
+    compiler->IncrementalDirectory = BinaryDir / "incremental";
+
+    if (getType() == TargetType::RustExecutable)
+    {
+        compiler->Extension = getBuildSettings().TargetOS.getExecutableExtension();
+        compiler->setOutputFile(getBaseOutputFileName(*this, {}, "bin"));
+    }
+    else
+    {
+        // rustc looks for lib<crate>.rlib/.rmeta when resolving indirect dependencies
+        compiler->CrateType = rust::CrateType::rlib;
+        compiler->Output = BinaryDir / ("lib" + crate + ".rlib");
+        compiler->MetadataOutput = getMetadataFile();
+    }
 
     SW_RETURN_MULTIPASS_END(init_pass);
 }
 
+path RustTarget::getMetadataFile() const
+{
+    return path(compiler->Output()).replace_extension(".rmeta");
+}
+
+static void gatherRustDependencies(const RustTarget &t, std::vector<const RustTarget *> &deps)
+{
+    for (auto &d : t.gatherDependencies())
+    {
+        auto r = d->getTarget().as<RustTarget *>();
+        if (!r || std::find(deps.begin(), deps.end(), r) != deps.end())
+            continue;
+        deps.push_back(r);
+        gatherRustDependencies(*r, deps);
+    }
+}
+
 Commands RustTarget::getCommands1() const
 {
-    for (auto f : gatherSourceFiles<SourceFile>(*this, {".rs"}))
-        compiler->setSourceFile(f->file);
+    // rustc takes only the crate root, other modules are found by rustc and come from dep-info
+    path root;
+    auto files = gatherSourceFiles<SourceFile>(*this, {".rs"});
+    for (auto f : files)
+    {
+        auto fn = f->file.filename();
+        if (fn == (getType() == TargetType::RustExecutable ? "main.rs" : "lib.rs") || files.size() == 1)
+            root = f->file;
+    }
+    if (root.empty())
+        throw SW_RUNTIME_ERROR(getPackage().toString() + ": cannot find crate root, add main.rs or lib.rs");
+    compiler->setSourceFile(root);
+
+    std::vector<const RustTarget *> deps;
+    gatherRustDependencies(*this, deps);
+
+    // Libraries are built against metadata of their dependencies, linking needs full rlibs of the whole tree.
+    // Both are written by one rustc invocation, so every crate is checked once.
+    bool link = getType() == TargetType::RustExecutable;
+    auto add_deps = [this, &deps, link](builder::Command &c)
+    {
+        for (auto d : deps)
+        {
+            auto f = link ? d->compiler->Output() : d->getMetadataFile();
+            // direct ones are visible to code, indirect ones are looked up by rustc
+            bool direct = false;
+            for (auto &d2 : gatherDependencies())
+                direct |= d2->getTarget().as<RustTarget *>() == d;
+            if (direct)
+            {
+                c.push_back("--extern");
+                c.push_back(d->compiler->CrateName() + "=" + normalize_path(f));
+            }
+            c.push_back("-L");
+            c.push_back("dependency=" + normalize_path(f.parent_path()));
+            c.addInput(f);
+        }
+    };
 
     Commands cmds;
     auto c = compiler->getCommand(*this);
+    add_deps(*c);
     cmds.insert(c);
     return cmds;
 }
@@ -244,6 +322,9 @@ static void detectFortranCompilers(DETECT_ARGS)
     addProgram(s, PackageId("org.gnu.gcc.fortran", v), {}, p);
 }
 
+static const StringSet fortran_fixed_form_extensions{ ".f", ".for", ".f77", ".F", ".FOR" };
+static const StringSet fortran_extensions{ ".f", ".for", ".f77", ".f90", ".f95", ".f03", ".f08", ".F", ".FOR", ".F90" };
+
 bool FortranTarget::init()
 {
     static std::once_flag f;
@@ -270,7 +351,7 @@ bool FortranTarget::init()
     ".fpp",
     ".FPP",
     };*/
-    compiler = activateCompiler<decltype(compiler)::element_type>(*this, "org.gnu.gcc.fortran"s, { ".f" });
+    compiler = activateCompiler<decltype(compiler)::element_type>(*this, "org.gnu.gcc.fortran"s, fortran_extensions);
     if (!compiler)
         throw SW_RUNTIME_ERROR("No Fortran compiler found");
 
@@ -280,12 +361,200 @@ bool FortranTarget::init()
     SW_RETURN_MULTIPASS_END(init_pass);
 }
 
+struct FortranModules
+{
+    // .mod and .smod file names
+    StringSet provides;
+    StringSet uses;
+};
+
+// finds module, submodule and use statements
+static FortranModules scanFortranModules(const path &fn)
+{
+    FortranModules m;
+
+    bool fixed_form = fortran_fixed_form_extensions.find(fn.extension().string()) != fortran_fixed_form_extensions.end();
+
+    auto handle_statement = [&m](String s)
+    {
+        boost::trim(s);
+        if (s.empty())
+            return;
+        boost::to_lower(s);
+
+        Strings w;
+        boost::split(w, s, boost::is_any_of(" \t"), boost::token_compress_on);
+
+        // module X, but not 'module procedure/function/subroutine ...'
+        if (w[0] == "module")
+        {
+            if (w.size() == 2 && w[1] != "procedure")
+                m.provides.insert(w[1] + ".mod");
+            return;
+        }
+
+        // submodule (ancestor[:parent]) name
+        if (boost::starts_with(w[0], "submodule"))
+        {
+            auto b = s.find('(');
+            auto e = s.find(')');
+            if (b == s.npos || e == s.npos || e < b)
+                return;
+            auto parent = s.substr(b + 1, e - b - 1);
+            auto name = boost::trim_copy(s.substr(e + 1));
+            boost::erase_all(parent, " ");
+            boost::erase_all(parent, "\t");
+            if (parent.empty() || name.empty())
+                return;
+            auto p = parent.find(':');
+            auto ancestor = parent.substr(0, p);
+            m.uses.insert(ancestor + ".mod");
+            if (p != parent.npos)
+                m.uses.insert(ancestor + "@" + parent.substr(p + 1) + ".smod");
+            m.provides.insert(ancestor + "@" + name + ".smod");
+            return;
+        }
+
+        // use X; use :: X; use, non_intrinsic :: X; use X, only: ...
+        if (!boost::starts_with(w[0], "use") || (w[0] != "use" && w[0][3] != ',' && w[0][3] != ':'))
+            return;
+        auto rest = s.substr(3);
+        auto dc = rest.find("::");
+        if (dc != rest.npos)
+        {
+            if (rest.substr(0, dc).find("intrinsic") != rest.npos &&
+                rest.substr(0, dc).find("non_intrinsic") == rest.npos)
+                return;
+            rest = rest.substr(dc + 2);
+        }
+        else if (boost::trim_copy(rest)[0] == ',')
+            return; // unknown form
+        boost::trim(rest);
+        auto end = rest.find_first_of(", \t");
+        auto name = rest.substr(0, end);
+        if (!name.empty())
+            m.uses.insert(name + ".mod");
+    };
+
+    std::istringstream ss(read_file(fn));
+    String line, statement;
+    while (std::getline(ss, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.resize(line.size() - 1);
+        if (fixed_form && !line.empty() && (line[0] == 'c' || line[0] == 'C' || line[0] == '*'))
+            continue;
+
+        // strip comments, split statements
+        char quote = 0;
+        String cur;
+        bool continued = false;
+        for (auto c : line)
+        {
+            if (quote)
+            {
+                if (c == quote)
+                    quote = 0;
+                cur += c;
+                continue;
+            }
+            if (c == '\'' || c == '"')
+                quote = c;
+            else if (c == '!')
+                break;
+            else if (c == ';')
+            {
+                handle_statement(statement + cur);
+                statement.clear();
+                cur.clear();
+                continue;
+            }
+            cur += c;
+        }
+
+        // free form continuation
+        auto t = boost::trim_copy(cur);
+        if (!fixed_form && !t.empty() && t.back() == '&')
+        {
+            t.resize(t.size() - 1);
+            continued = true;
+        }
+        if (!fixed_form && !t.empty() && t[0] == '&')
+            t = t.substr(1);
+        statement += " " + t;
+        if (continued)
+            continue;
+        handle_statement(statement);
+        statement.clear();
+    }
+    handle_statement(statement);
+
+    // module may be used in the same file
+    for (auto &p : m.provides)
+        m.uses.erase(p);
+    return m;
+}
+
 Commands FortranTarget::getCommands1() const
 {
-    for (auto f : gatherSourceFiles<SourceFile>(*this, {".f"}))
-        compiler->setSourceFile(f->file);
+    auto files = gatherSourceFiles<SourceFile>(*this, fortran_extensions);
+    std::vector<path> sources;
+    for (auto f : files)
+        sources.push_back(f->file);
+    std::sort(sources.begin(), sources.end());
+
+    auto obj_dir = BinaryPrivateDir / "obj";
+    auto mod_dir = BinaryDir / "mod";
+    fs::create_directories(mod_dir);
 
+    // one command per file, so files are compiled in parallel and rebuilt separately
     Commands cmds;
+    std::vector<FortranModules> modules;
+    std::vector<std::shared_ptr<builder::Command>> compile_cmds;
+    Files objs;
+    for (auto &f : sources)
+    {
+        auto c = std::static_pointer_cast<FortranCompiler>(compiler->clone());
+        c->CompileWithoutLinking = true;
+        c->ModuleDirectory = mod_dir;
+        c->InputFiles().clear();
+        c->setSourceFile(f);
+        auto o = obj_dir / (SourceFile::getObjectFilename(*this, f) += ".o");
+        c->Output = o;
+        objs.insert(o);
+
+        auto cmd = c->getCommand(*this);
+        cmd->name = normalize_path(f);
+        cmds.insert(cmd);
+        compile_cmds.push_back(cmd);
+        modules.push_back(scanFortranModules(f));
+    }
+
+    // .mod files connect producers and consumers
+    StringSet provided;
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        for (auto &m : modules[i].provides)
+        {
+            if (!provided.insert(m).second)
+                throw SW_RUNTIME_ERROR(getPackage().toString() + ": module file " + m + " is produced by more than one source");
+            compile_cmds[i]->addOutput(mod_dir / m);
+        }
+    }
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        for (auto &m : modules[i].uses)
+        {
+            // intrinsic or external modules
+            if (provided.find(m) == provided.end())
+                continue;
+            compile_cmds[i]->addInput(mod_dir / m);
+        }
+    }
+
+    // link
+    compiler->CompileWithoutLinking = false;
+    compiler->InputFiles() = objs;
     auto c = compiler->getCommand(*this);
     cmds.insert(c);
     return cmds;
@@ -305,6 +574,66 @@ void detectJavaCompilers(DETECT_ARGS)
     addProgram(s, PackageId("com.oracle.java.javac", v), {}, p);
 }
 
+static path getJvmClassesDir(const Target &t)
+{
+    return t.BinaryDir / "classes";
+}
+
+static path getJvmAbiFile(const Target &t)
+{
+    return t.BinaryDir / "jvm.abi";
+}
+
+static void setJvmInterfaceSettings(const Target &t, TargetSettings &s)
+{
+    s["jvm"]["classes_dir"] = normalize_path(getJvmClassesDir(t));
+    s["jvm"]["abi"] = normalize_path(getJvmAbiFile(t));
+}
+
+// class path of jvm dependencies,
+// their abi files are inputs, so we are not rebuilt when only their implementation changes
+static Files addJvmDependencies(const Target &t, builder::Command &c, const path &classes_dir)
+{
+    FilesOrdered classpath;
+    if (!classes_dir.empty())
+        classpath.push_back(classes_dir);
+    Files abi_files;
+    for (auto d : t.getDependencies())
+    {
+        if (!d->isResolved())
+            continue;
+        auto &s = d->getTarget().getInterfaceSettings()["jvm"];
+        if (!s["classes_dir"])
+            continue;
+        classpath.push_back(fs::u8path(s["classes_dir"].getValue()));
+        abi_files.insert(fs::u8path(s["abi"].getValue()));
+    }
+    if (classpath.empty())
+        return abi_files;
+
+#ifdef _WIN32
+    static const auto sep = ";";
+#else
+    static const auto sep = ":";
+#endif
+    String cp;
+    for (auto &p : classpath)
+        cp += normalize_path(p) + sep;
+    cp.resize(cp.size() - 1);
+    c.push_back("-cp");
+    c.push_back(cp);
+    c.addInput(abi_files);
+    return abi_files;
+}
+
+static void setupJvmCommand(const Target &t, driver::JvmCommand &c)
+{
+    c.state_file = t.BinaryPrivateDir / "jvm.state";
+    c.abi_file = getJvmAbiFile(t);
+    c.addOutput(c.abi_file);
+    c.dependency_abi_files = addJvmDependencies(t, c, c.classes_dir);
+}
+
 bool JavaTarget::init()
 {
     static std::once_flag f;
@@ -322,7 +651,8 @@ bool JavaTarget::init()
     if (!compiler)
         throw SW_RUNTIME_ERROR("No Java compiler found");
 
-    compiler->setOutputDir(getBaseOutputDirName(*this, {}, "bin"));
+    compiler->setOutputDir(getJvmClassesDir(*this));
+    setJvmInterfaceSettings(*this, interface_settings);
 
     SW_RETURN_MULTIPASS_END(init_pass);
 }
@@ -335,7 +665,8 @@ Commands JavaTarget::getCommands1() const
         compiler->setSourceFile(f->file);
     }
 
-    auto c = compiler->getCommand(*this);
+    auto c = std::static_pointer_cast<driver::JvmCommand>(compiler->getCommand(*this));
+    setupJvmCommand(*this, *c);
     cmds.insert(c);
     return cmds;
 }
@@ -369,7 +700,14 @@ bool KotlinTarget::init()
     if (!compiler)
         throw SW_RUNTIME_ERROR("No Kotlin compiler found");
 
-    compiler->setOutputFile(getBaseOutputFileName(*this, {}, "bin"));
+    // executables are runnable jars, libraries are class directories for their users
+    if (getType() == TargetType::KotlinExecutable)
+        compiler->setOutputFile(getBaseOutputFileName(*this, {}, "bin"));
+    else
+    {
+        compiler->setOutputDir(getJvmClassesDir(*this));
+        setJvmInterfaceSettings(*this, interface_settings);
+    }
 
     SW_RETURN_MULTIPASS_END(init_pass);
 }
@@ -381,6 +719,10 @@ Commands KotlinTarget::getCommands1() const
 
     Commands cmds;
     auto c = compiler->getCommand(*this);
+    if (auto jc = std::dynamic_pointer_cast<driver::JvmCommand>(c))
+        setupJvmCommand(*this, *jc);
+    else
+        addJvmDependencies(*this, *c, {});
     cmds.insert(c);
     return cmds;
 }
@@ -441,15 +783,43 @@ bool DTarget::init()
 
 Commands DTarget::getCommands1() const
 {
+    Commands cmds;
+
+    // -makedeps appeared in dmd 2.095, older ones build everything in one command
+    if (getVersion(getMainBuild().getContext(), compiler->file) < Version(2, 95))
+    {
+        for (auto f : gatherSourceFiles<SourceFile>(*this, {".d"}))
+            compiler->setSourceFile(f->file);
+        for (auto &d : this->gatherDependencies())
+            compiler->setSourceFile(d->getTarget().as<DTarget &>().compiler->getOutputFile());
+        cmds.insert(compiler->getCommand(*this));
+        return cmds;
+    }
+
+    // modules are found by import paths now, not by other files on the command line
+    FilesOrdered imports{ SourceDir };
+    for (auto &d : this->gatherDependencies())
+        imports.push_back(d->getTarget().as<DTarget &>().SourceDir);
+
+    // one command per module, so modules are compiled in parallel and rebuilt separately,
+    // imported modules are implicit inputs from deps file
+    auto obj_dir = BinaryPrivateDir / "obj";
     for (auto f : gatherSourceFiles<SourceFile>(*this, {".d"}))
-        compiler->setSourceFile(f->file/*, BinaryDir.parent_path() / "obj" / f->file.filename()*/);
+    {
+        auto c = std::make_shared<DModuleCompiler>(compiler->swctx);
+        c->file = compiler->file;
+        c->ImportDirectories() = imports;
+        auto o = obj_dir / (SourceFile::getObjectFilename(*this, f->file) += getBuildSettings().TargetOS.getObjectFileExtension());
+        c->setSourceFile(f->file, o);
+        cmds.insert(c->getCommand(*this));
+        compiler->setSourceFile(o);
+    }
 
     // add prepare() to propagate deps
     // here we check only our deps
     for (auto &d : this->gatherDependencies())
         compiler->setSourceFile(d->getTarget().as<DTarget &>().compiler->getOutputFile());
 
-    Commands cmds;
     auto c = compiler->getCommand(*this);
     cmds.insert(c);
     return cmds;
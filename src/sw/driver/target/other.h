@@ -50,6 +50,9 @@ struct SW_DRIVER_CPP_API RustTarget : Target
     DependenciesType gatherDependencies() const override { return NativeTargetOptionsGroup::gatherDependencies(); }
     Files gatherAllFiles() const override { return NativeTargetOptionsGroup::gatherAllFiles(); }
 
+    /// .rmeta of a library crate, written with its .rlib
+    path getMetadataFile() const;
+
 private:
     Commands getCommands1() const override;
 };
@@ -8,6 +8,7 @@
 
 #include "enums.h"
 #include "inserts.h"
+#include "packages_index.h"
 #include "settings.h"
 #include "stamp.h"
 #include "storage.h"
@@ -208,34 +209,99 @@ void PackagesDatabase::open(bool read_only, bool in_memory)
 {
     Database::open(read_only, in_memory);
     pps = std::make_unique<PreparedStatements>(*db);
+    clearCache();
+}
+
+template <class C, class F>
+static String makeInList(const C &c, F &&f)
+{
+    String s;
+    for (auto &e : c)
+        s += f(e) + ", ";
+    if (!s.empty())
+        s.resize(s.size() - 2);
+    return s;
+}
+
+void PackagesDatabase::loadPackageVersions(const std::unordered_set<PackagePath> &paths) const
+{
+    // versions_mutex must be held by the caller
+
+    // mark all as missing first, so we won't query them again
+    for (auto &p : paths)
+        versions[p];
+
+    std::unordered_map<db::PackageId, PackageVersions *> ids;
+    for (const auto &row : (*db)(
+        custom_query(sqlpp::verbatim("SELECT package_id, path FROM package WHERE path IN (" +
+            makeInList(paths, [](const auto &p) { return "'" + p.toString() + "'"; }) + ") COLLATE NOCASE"))
+        .with_result_type_of(select(pkgs.packageId, pkgs.path).from(pkgs))
+        ))
+    {
+        auto &pv = versions[PackagePath(row.path.value())];
+        pv.id = row.packageId.value();
+        ids[pv.id] = &pv;
+    }
+    if (ids.empty())
+        return;
+
+    for (const auto &row : (*db)(
+        custom_query(sqlpp::verbatim("SELECT package_version_id, package_id, version FROM package_version WHERE package_id IN (" +
+            makeInList(ids, [](const auto &p) { return std::to_string(p.first); }) + ")"))
+        .with_result_type_of(select(pkg_ver.packageVersionId, pkg_ver.packageId, pkg_ver.version).from(pkg_ver))
+        ))
+    {
+        auto &pv = *ids[row.packageId.value()];
+        pv.versions.insert(row.version.value());
+        pv.version_ids[row.version.value()] = row.packageVersionId.value();
+    }
+}
+
+void PackagesDatabase::clearCache() const
+{
+    setIndex({});
+    std::unique_lock lk(versions_mutex);
+    versions.clear();
+}
+
+void PackagesDatabase::setIndex(const std::shared_ptr<const PackagesIndex> &i) const
+{
+    std::atomic_store(&index, i);
+}
+
+std::shared_ptr<const PackagesIndex> PackagesDatabase::getIndex() const
+{
+    return std::atomic_load(&index);
 }
 
 std::unordered_map<UnresolvedPackage, PackageId> PackagesDatabase::resolve(const UnresolvedPackages &in_pkgs, UnresolvedPackages &unresolved_pkgs) const
 {
+    if (auto i = getIndex())
+        return i->resolve(in_pkgs, unresolved_pkgs);
+
+    std::unique_lock lk(versions_mutex);
+
+    // load the whole frontier with two queries
+    std::unordered_set<PackagePath> missing;
+    for (auto &pkg : in_pkgs)
+    {
+        if (versions.find(pkg.ppath) == versions.end())
+            missing.insert(pkg.ppath);
+    }
+    if (!missing.empty())
+        loadPackageVersions(missing);
+
     std::unordered_map<UnresolvedPackage, PackageId> r;
     for (auto &pkg : in_pkgs)
     {
-        auto pid = getPackageId(pkg.ppath);
-        if (!pid)
+        auto &pv = versions.find(pkg.ppath)->second;
+        if (!pv.id)
         {
             unresolved_pkgs.insert(pkg);
             continue;
         }
 
-        db::PackageVersionId id = 0;
-        VersionSet versions;
-        UnorderedVersionMap<db::PackageVersionId> version_ids;
-
-        for (const auto &row : (*db)(
-            select(pkg_ver.packageVersionId, pkg_ver.version)
-            .from(pkg_ver)
-            .where(pkg_ver.packageId == pid)))
-        {
-            versions.insert(row.version.value());
-            version_ids[row.version.value()] = row.packageVersionId.value();
-        }
-
-        auto v = pkg.range.getMaxSatisfyingVersion(versions);
+        auto v = pkg.range.getMaxSatisfyingVersion(pv.versions);
         if (!v)
         {
             unresolved_pkgs.insert(pkg);
@@ -249,6 +315,9 @@ std::unordered_map<UnresolvedPackage, PackageId> PackagesDatabase::resolve(const
 
 PackageData PackagesDatabase::getPackageData(const PackageId &p) const
 {
+    if (auto i = getIndex())
+        return i->getPackageData(p);
+
     PackageData d;
 
     auto &pp = pps->packageVersionData;
@@ -278,6 +347,73 @@ PackageData PackagesDatabase::getPackageData(const PackageId &p) const
     return d;
 }
 
+std::unordered_map<PackageId, PackageData> PackagesDatabase::getPackageData(const std::vector<PackageId> &in_pkgs) const
+{
+    std::unordered_map<PackageId, PackageData> r;
+    if (in_pkgs.empty())
+        return r;
+
+    if (auto i = getIndex())
+    {
+        for (auto &p : in_pkgs)
+            r.emplace(p, i->getPackageData(p));
+        return r;
+    }
+
+    std::unordered_map<db::PackageVersionId, PackageId> ids;
+    {
+        std::unique_lock lk(versions_mutex);
+
+        std::unordered_set<PackagePath> missing;
+        for (auto &p : in_pkgs)
+        {
+            if (versions.find(p.getPath()) == versions.end())
+                missing.insert(p.getPath());
+        }
+        if (!missing.empty())
+            loadPackageVersions(missing);
+
+        for (auto &p : in_pkgs)
+        {
+            auto &pv = versions.find(p.getPath())->second;
+            auto i = pv.version_ids.find(p.getVersion());
+            if (i == pv.version_ids.end())
+                throw SW_RUNTIME_ERROR("No such package in db: " + p.toString());
+            ids.emplace(i->second, p);
+        }
+    }
+
+    auto in = makeInList(ids, [](const auto &p) { return std::to_string(p.first); });
+
+    for (const auto &row : (*db)(
+        custom_query(sqlpp::verbatim("SELECT package_version_id, hash, flags, group_number, prefix, sdir FROM package_version "
+            "WHERE package_version_id IN (" + in + ")"))
+        .with_result_type_of(select(pkg_ver.packageVersionId, pkg_ver.hash, pkg_ver.flags, pkg_ver.groupNumber, pkg_ver.prefix, pkg_ver.sdir).from(pkg_ver))
+        ))
+    {
+        auto &d = r[ids.find(row.packageVersionId.value())->second];
+        d.hash = row.hash.value();
+        d.flags = row.flags.value();
+        d.group_number = row.groupNumber.value();
+        d.prefix = (int)row.prefix.value();
+        d.sdir = row.sdir.value();
+    }
+
+    for (const auto &row : (*db)(
+        custom_query(sqlpp::verbatim("SELECT package_version_dependency.package_version_id, package.path, package_version_dependency.version_range "
+            "FROM package_version_dependency JOIN package ON package_version_dependency.package_id = package.package_id "
+            "WHERE package_version_dependency.package_version_id IN (" + in + ")"))
+        .with_result_type_of(
+            select(pkg_deps.packageVersionId, pkgs.path, pkg_deps.versionRange)
+            .from(pkg_deps.join(pkgs).on(pkg_deps.packageId == pkgs.packageId)))
+        ))
+    {
+        r[ids.find(row.packageVersionId.value())->second].dependencies.emplace(row.path.value(), row.versionRange.value());
+    }
+
+    return r;
+}
+
 int64_t PackagesDatabase::getInstalledPackageId(const PackageId &p) const
 {
     return getPackageVersionId(p);
@@ -397,6 +533,8 @@ void PackagesDatabase::installPackage(const PackageId &p, const PackageData &d)
 
     db->execute("COMMIT");
     sg.dismiss();
+
+    clearCache();
 }
 
 void PackagesDatabase::installPackage(const Package &p)
@@ -434,6 +572,7 @@ void PackagesDatabase::deletePackage(const PackageId &p) const
         remove_from(pkg_ver)
         .where(pkg_ver.packageId == getPackageId(p.getPath()) && pkg_ver.version == p.getVersion().toString())
         );
+    clearCache();
 }
 
 void PackagesDatabase::deleteOverriddenPackageDir(const path &sdir) const
@@ -442,10 +581,14 @@ void PackagesDatabase::deleteOverriddenPackageDir(const path &sdir) const
         remove_from(pkg_ver)
         .where(pkg_ver.sdir == sdir.u8string())
         );
+    clearCache();
 }
 
 std::vector<PackagePath> PackagesDatabase::getMatchingPackages(const String &name) const
 {
+    if (auto i = getIndex())
+        return i->getMatchingPackages(name);
+
     std::vector<PackagePath> pkgs2;
     String q;
     if (name.empty())
@@ -464,6 +607,9 @@ std::vector<PackagePath> PackagesDatabase::getMatchingPackages(const String &nam
 
 std::vector<Version> PackagesDatabase::getVersionsForPackage(const PackagePath &ppath) const
 {
+    if (auto i = getIndex())
+        return i->getVersionsForPackage(ppath);
+
     std::vector<Version> versions;
     for (const auto &row : (*db)(select(pkg_ver.version).from(pkg_ver).where(pkg_ver.packageId == getPackageId(ppath))))
         versions.push_back(row.version.value());
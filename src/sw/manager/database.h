@@ -26,6 +26,7 @@ namespace sw
 
 struct LocalStorage;
 struct PackageId;
+struct PackagesIndex;
 
 struct SW_MANAGER_API Database
 {
@@ -62,6 +63,8 @@ struct SW_MANAGER_API PackagesDatabase : Database
     std::unordered_map<UnresolvedPackage, PackageId> resolve(const UnresolvedPackages &pkgs, UnresolvedPackages &unresolved_pkgs) const;
 
     PackageData getPackageData(const PackageId &) const;
+    // bulk version, all packages must be present in db
+    std::unordered_map<PackageId, PackageData> getPackageData(const std::vector<PackageId> &) const;
 
     int64_t getInstalledPackageId(const PackageId &) const;
     String getInstalledPackageHash(const PackageId &) const;
@@ -86,9 +89,31 @@ struct SW_MANAGER_API PackagesDatabase : Database
     std::vector<PackagePath> getMatchingPackages(const String &name = {}) const;
     std::vector<Version> getVersionsForPackage(const PackagePath &) const;
 
+    // must be called after external writes to db
+    void clearCache() const;
+
+    // read only snapshot of this db, reads are served from it without locking
+    // dropped on every write
+    void setIndex(const std::shared_ptr<const PackagesIndex> &) const;
+    std::shared_ptr<const PackagesIndex> getIndex() const;
+
 private:
+    struct PackageVersions
+    {
+        db::PackageId id = 0;
+        VersionSet versions;
+        UnorderedVersionMap<db::PackageVersionId> version_ids;
+    };
+
     std::mutex m;
     std::unique_ptr<struct PreparedStatements> pps;
+
+    // resolve cache, filled in bulk, dropped on every write
+    mutable std::mutex versions_mutex;
+    mutable std::unordered_map<PackagePath, PackageVersions> versions;
+    mutable std::shared_ptr<const PackagesIndex> index;
+
+    void loadPackageVersions(const std::unordered_set<PackagePath> &) const;
 };
 
 }
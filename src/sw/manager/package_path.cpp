@@ -7,8 +7,14 @@
 #include "package_path.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/lock_types.hpp>
+#include <boost/thread/shared_mutex.hpp>
 #include <primitives/templates.h>
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 namespace sw
 {
 
@@ -33,8 +39,63 @@ PackagePath::PackagePath(String s)
 }
 
 PackagePath::PackagePath(const PackagePath &p)
-    : Base(p, isValidPackagePathSymbol)
+    : Base(p), entry(p.entry)
+{
+}
+
+const detail::PackagePathEntry *PackagePath::intern() const
+{
+    // leaked on purpose, paths may be used during static destruction
+    static auto &m = *new boost::shared_mutex;
+    static auto &entries = *new std::unordered_map<String, std::unique_ptr<detail::PackagePathEntry>>;
+
+    auto s = Base::toStringLower();
+    {
+        boost::shared_lock lk(m);
+        auto i = entries.find(s);
+        if (i != entries.end())
+            return i->second.get();
+    }
+
+    std::unique_lock lk(m);
+    auto &e = entries[s];
+    if (!e)
+    {
+        e = std::make_unique<detail::PackagePathEntry>();
+        e->lower = s;
+        e->hash = Base::hash();
+        e->id = entries.size();
+    }
+    return e.get();
+}
+
+PackagePath PackagePath::operator/(const PackagePath &e) const
 {
+    PackagePath tmp = *this;
+    tmp.insert(tmp.end(), e.begin(), e.end());
+    tmp.entry = tmp.intern();
+    return tmp;
+}
+
+PackagePath PackagePath::operator/(const String &e) const
+{
+    return operator/(PackagePath(e));
+}
+
+PackagePath &PackagePath::operator/=(const PackagePath &e)
+{
+    return *this = *this / e;
+}
+
+PackagePath &PackagePath::operator/=(const String &e)
+{
+    return *this = *this / e;
+}
+
+void PackagePath::clear()
+{
+    Base::clear();
+    entry = intern();
 }
 
 PackagePath::Base::value_type PackagePath::getName() const
@@ -68,6 +129,8 @@ path PackagePath::toFileSystemPath() const
 
 bool PackagePath::operator<(const PackagePath &p) const
 {
+    if (entry == p.entry)
+        return false;
     if (empty() && p.empty())
         return false;
     if (empty())
@@ -201,6 +264,7 @@ PackagePath PackagePath::back(const PackagePath &root) const
     }
     if (p.empty())
         p.assign(end() - (size() - root.size()), end());
+    p.entry = p.intern();
     return p;
 }
 
@@ -253,6 +253,20 @@ template struct SW_MANAGER_API PathBase<Path>;
 template struct PathBase<Path>;
 #endif
 
+namespace detail
+{
+
+// canonical (lower case) form of package path,
+// stored once per process and never freed
+struct PackagePathEntry
+{
+    String lower;
+    size_t hash;
+    size_t id;
+};
+
+}
+
 struct SW_MANAGER_API PackagePath : SecureSplitablePath<PackagePath>
 {
     using Base = SecureSplitablePath<PackagePath>;
@@ -293,6 +307,23 @@ struct SW_MANAGER_API PackagePath : SecureSplitablePath<PackagePath>
     PackagePath operator[](ElementType e) const;
     bool operator<(const PackagePath &rhs) const;
 
+    // interned paths are compared by pointer
+    bool operator==(const PackagePath &rhs) const { return entry == rhs.entry; }
+    bool operator!=(const PackagePath &rhs) const { return !operator==(rhs); }
+
+    PackagePath &operator=(const PackagePath &) = default;
+    PackagePath operator/(const PackagePath &e) const;
+    PackagePath operator/(const String &e) const;
+    PackagePath &operator/=(const PackagePath &e);
+    PackagePath &operator/=(const String &e);
+
+    void clear();
+
+    String toStringLower() const { return entry->lower; }
+    size_t hash() const { return entry->hash; }
+    /// unique for each case insensitive path in this process
+    size_t getId() const { return entry->id; }
+
 #define PACKAGE_PATH(name)          \
     static PackagePath name()       \
     {                               \
@@ -308,7 +339,11 @@ struct SW_MANAGER_API PackagePath : SecureSplitablePath<PackagePath>
 #undef PACKAGE_PATH
 
 private:
+    const detail::PackagePathEntry *entry = intern();
+
     using Base::operator[];
+
+    const detail::PackagePathEntry *intern() const;
 };
 
 #if defined(_WIN32)// || defined(__APPLE__)
@@ -0,0 +1,429 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "packages_index.h"
+
+#include "database.h"
+
+#include <sw/support/mmap.h>
+
+#include <primitives/exceptions.h>
+#include <primitives/templates.h>
+#include <sqlite3.h>
+#include <sqlpp11/sqlite3/connection.h>
+
+#include <fstream>
+#include <string_view>
+
+#define PACKAGES_INDEX_MAGIC 0x49505753 // SWPI
+#define PACKAGES_INDEX_FORMAT_VERSION 1
+
+namespace sw
+{
+
+struct PackagesIndexString
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct PackagesIndexHeader
+{
+    uint32_t magic;
+    uint32_t format_version;
+    int64_t db_version;
+    uint64_t n_packages;
+    uint64_t n_versions;
+    uint64_t n_deps;
+    uint64_t strings_size;
+};
+
+struct PackagesIndexPackage
+{
+    PackagesIndexString path;
+    PackagesIndexString path_lower; // sort key
+    uint32_t first_version;
+    uint32_t n_versions;
+};
+
+struct PackagesIndexVersion
+{
+    PackagesIndexString version;
+    PackagesIndexString hash;
+    int64_t flags;
+    int64_t group_number;
+    int32_t prefix;
+    uint32_t package;
+    uint32_t first_dep;
+    uint32_t n_deps;
+};
+
+struct PackagesIndexDependency
+{
+    uint32_t package;
+    PackagesIndexString range;
+};
+
+static String to_lower(String s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)::tolower(c); });
+    return s;
+}
+
+template <class F>
+static void query(sqlite3 *db, const String &q, F &&f)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, q.c_str(), (int)q.size() + 1, &stmt, 0) != SQLITE_OK)
+        throw SW_RUNTIME_ERROR(sqlite3_errmsg(db));
+    SCOPE_EXIT
+    {
+        sqlite3_finalize(stmt);
+    };
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        f(stmt);
+    if (rc != SQLITE_DONE)
+        throw SW_RUNTIME_ERROR("sqlite3_step() failed: "s + sqlite3_errmsg(db));
+}
+
+static String column_text(sqlite3_stmt *stmt, int i)
+{
+    auto s = (const char *)sqlite3_column_text(stmt, i);
+    return s ? s : "";
+}
+
+void PackagesIndex::write(const PackagesDatabase &pdb, const path &fn, int64_t db_version)
+{
+    struct Dependency
+    {
+        int64_t package_id;
+        String range;
+    };
+
+    struct VersionData
+    {
+        int64_t id;
+        String version;
+        String hash;
+        int64_t flags;
+        int64_t group_number;
+        int32_t prefix;
+        std::vector<Dependency> deps;
+    };
+
+    struct PackageInfo
+    {
+        int64_t id;
+        String path;
+        String path_lower;
+        std::vector<VersionData> versions;
+    };
+
+    auto db = pdb.db->native_handle();
+
+    std::vector<PackageInfo> pkgs;
+    query(db, "SELECT package_id, path FROM package", [&pkgs](auto stmt)
+    {
+        auto p = column_text(stmt, 1);
+        pkgs.push_back({ sqlite3_column_int64(stmt, 0), p, to_lower(p) });
+    });
+    std::sort(pkgs.begin(), pkgs.end(), [](const auto &p1, const auto &p2)
+    {
+        return p1.path_lower < p2.path_lower;
+    });
+
+    std::unordered_map<int64_t, uint32_t> package_idx;
+    for (uint32_t i = 0; i < pkgs.size(); i++)
+        package_idx[pkgs[i].id] = i;
+
+    std::unordered_map<int64_t, VersionData *> version_ptrs;
+    query(db, "SELECT package_version_id, package_id, version, flags, group_number, prefix, hash FROM package_version",
+        [&pkgs, &package_idx](auto stmt)
+    {
+        auto i = package_idx.find(sqlite3_column_int64(stmt, 1));
+        if (i == package_idx.end())
+            return;
+        VersionData v;
+        v.id = sqlite3_column_int64(stmt, 0);
+        v.version = column_text(stmt, 2);
+        v.flags = sqlite3_column_int64(stmt, 3);
+        v.group_number = sqlite3_column_int64(stmt, 4);
+        v.prefix = sqlite3_column_int(stmt, 5);
+        v.hash = column_text(stmt, 6);
+        pkgs[i->second].versions.push_back(std::move(v));
+    });
+    // pointers are stable from here
+    for (auto &p : pkgs)
+    {
+        for (auto &v : p.versions)
+            version_ptrs[v.id] = &v;
+    }
+
+    query(db, "SELECT package_version_id, package_id, version_range FROM package_version_dependency",
+        [&version_ptrs](auto stmt)
+    {
+        auto i = version_ptrs.find(sqlite3_column_int64(stmt, 0));
+        if (i == version_ptrs.end())
+            return;
+        i->second->deps.push_back({ sqlite3_column_int64(stmt, 1), column_text(stmt, 2) });
+    });
+
+    // flatten
+    String strings;
+    auto add_string = [&strings](const String &s)
+    {
+        PackagesIndexString r;
+        r.offset = (uint32_t)strings.size();
+        r.size = (uint32_t)s.size();
+        strings += s;
+        return r;
+    };
+
+    std::vector<PackagesIndexPackage> out_pkgs;
+    std::vector<PackagesIndexVersion> out_versions;
+    std::vector<PackagesIndexDependency> out_deps;
+    out_pkgs.reserve(pkgs.size());
+    for (uint32_t i = 0; i < pkgs.size(); i++)
+    {
+        auto &p = pkgs[i];
+        PackagesIndexPackage op;
+        op.path = add_string(p.path);
+        op.path_lower = add_string(p.path_lower);
+        op.first_version = (uint32_t)out_versions.size();
+        op.n_versions = (uint32_t)p.versions.size();
+        out_pkgs.push_back(op);
+
+        for (auto &v : p.versions)
+        {
+            PackagesIndexVersion ov;
+            ov.version = add_string(v.version);
+            ov.hash = add_string(v.hash);
+            ov.flags = v.flags;
+            ov.group_number = v.group_number;
+            ov.prefix = v.prefix;
+            ov.package = i;
+            ov.first_dep = (uint32_t)out_deps.size();
+            ov.n_deps = 0;
+            for (auto &d : v.deps)
+            {
+                auto pi = package_idx.find(d.package_id);
+                if (pi == package_idx.end())
+                    continue;
+                out_deps.push_back({ pi->second, add_string(d.range) });
+                ov.n_deps++;
+            }
+            out_versions.push_back(ov);
+        }
+    }
+
+    PackagesIndexHeader h;
+    h.magic = PACKAGES_INDEX_MAGIC;
+    h.format_version = PACKAGES_INDEX_FORMAT_VERSION;
+    h.db_version = db_version;
+    h.n_packages = out_pkgs.size();
+    h.n_versions = out_versions.size();
+    h.n_deps = out_deps.size();
+    h.strings_size = strings.size();
+
+    // write into temp file and rename,
+    // so readers in other processes never see partial index
+    auto tmp = path(fn) += "." + unique_path().string();
+    {
+        std::ofstream ofile(tmp, std::ios::binary);
+        if (!ofile)
+            throw SW_RUNTIME_ERROR("Cannot open file " + normalize_path(tmp) + " for writing");
+        ofile.write((const char *)&h, sizeof(h));
+        ofile.write((const char *)out_pkgs.data(), out_pkgs.size() * sizeof(PackagesIndexPackage));
+        ofile.write((const char *)out_versions.data(), out_versions.size() * sizeof(PackagesIndexVersion));
+        ofile.write((const char *)out_deps.data(), out_deps.size() * sizeof(PackagesIndexDependency));
+        ofile.write(strings.data(), strings.size());
+        if (!ofile)
+            throw SW_RUNTIME_ERROR("Cannot write file " + normalize_path(tmp));
+    }
+    error_code ec;
+    fs::rename(tmp, fn, ec);
+    if (ec)
+    {
+        // index is mapped by someone else (windows)
+        fs::remove(tmp, ec);
+    }
+}
+
+PackagesIndex::PackagesIndex(const path &fn)
+    : f(std::make_unique<MappedFile>(fn))
+{
+    auto bad = [&fn]()
+    {
+        return SW_RUNTIME_ERROR("Bad packages index: " + normalize_path(fn));
+    };
+
+    if (f->size() < sizeof(PackagesIndexHeader))
+        throw bad();
+    header = (const PackagesIndexHeader *)f->data();
+    if (header->magic != PACKAGES_INDEX_MAGIC || header->format_version != PACKAGES_INDEX_FORMAT_VERSION)
+        throw bad();
+    // counts are checked one by one, so the sum below cannot overflow
+    auto sz = f->size();
+    if (header->n_packages > sz / sizeof(PackagesIndexPackage) ||
+        header->n_versions > sz / sizeof(PackagesIndexVersion) ||
+        header->n_deps > sz / sizeof(PackagesIndexDependency) ||
+        header->strings_size > sz)
+        throw bad();
+    if (sz != sizeof(PackagesIndexHeader) +
+        header->n_packages * sizeof(PackagesIndexPackage) +
+        header->n_versions * sizeof(PackagesIndexVersion) +
+        header->n_deps * sizeof(PackagesIndexDependency) +
+        header->strings_size)
+        throw bad();
+
+    packages = (const PackagesIndexPackage *)(header + 1);
+    versions = (const PackagesIndexVersion *)(packages + header->n_packages);
+    deps = (const PackagesIndexDependency *)(versions + header->n_versions);
+    strings = (const char *)(deps + header->n_deps);
+
+    // lookups do not check ranges, so every reference is checked once here
+    auto check_string = [this](const PackagesIndexString &s)
+    {
+        return (uint64_t)s.offset + s.size <= header->strings_size;
+    };
+    auto check_range = [](uint64_t first, uint64_t n, uint64_t total)
+    {
+        return first <= total && n <= total - first;
+    };
+    for (auto p = packages; p != packages + header->n_packages; p++)
+    {
+        if (!check_string(p->path) || !check_string(p->path_lower) ||
+            !check_range(p->first_version, p->n_versions, header->n_versions))
+            throw bad();
+    }
+    for (auto v = versions; v != versions + header->n_versions; v++)
+    {
+        if (!check_string(v->version) || !check_string(v->hash) ||
+            v->package >= header->n_packages ||
+            !check_range(v->first_dep, v->n_deps, header->n_deps))
+            throw bad();
+    }
+    for (auto d = deps; d != deps + header->n_deps; d++)
+    {
+        if (!check_string(d->range) || d->package >= header->n_packages)
+            throw bad();
+    }
+}
+
+PackagesIndex::~PackagesIndex() = default;
+
+int64_t PackagesIndex::getDatabaseVersion() const
+{
+    return header->db_version;
+}
+
+std::string_view PackagesIndex::getString(const PackagesIndexString &s) const
+{
+    if ((uint64_t)s.offset + s.size > header->strings_size)
+        throw SW_RUNTIME_ERROR("Bad string in packages index");
+    return { strings + s.offset, s.size };
+}
+
+const PackagesIndexPackage *PackagesIndex::findPackage(const PackagePath &p) const
+{
+    auto s = p.toStringLower();
+    auto e = packages + header->n_packages;
+    auto i = std::lower_bound(packages, e, s, [this](const auto &p, const auto &s)
+    {
+        return getString(p.path_lower) < s;
+    });
+    if (i == e || getString(i->path_lower) != s)
+        return nullptr;
+    return i;
+}
+
+const PackagesIndexVersion *PackagesIndex::findVersion(const PackageId &id) const
+{
+    auto p = findPackage(id.getPath());
+    if (!p)
+        return nullptr;
+    for (auto v = versions + p->first_version; v != versions + p->first_version + p->n_versions; v++)
+    {
+        if (Version(String(getString(v->version))) == id.getVersion())
+            return v;
+    }
+    return nullptr;
+}
+
+std::unordered_map<UnresolvedPackage, PackageId> PackagesIndex::resolve(const UnresolvedPackages &pkgs, UnresolvedPackages &unresolved_pkgs) const
+{
+    std::unordered_map<UnresolvedPackage, PackageId> r;
+    for (auto &pkg : pkgs)
+    {
+        auto p = findPackage(pkg.ppath);
+        if (!p)
+        {
+            unresolved_pkgs.insert(pkg);
+            continue;
+        }
+
+        VersionSet vs;
+        for (auto v = versions + p->first_version; v != versions + p->first_version + p->n_versions; v++)
+            vs.insert(String(getString(v->version)));
+
+        auto v = pkg.range.getMaxSatisfyingVersion(vs);
+        if (!v)
+        {
+            unresolved_pkgs.insert(pkg);
+            continue;
+        }
+
+        r.emplace(pkg, PackageId{ pkg.ppath, *v });
+    }
+    return r;
+}
+
+PackageData PackagesIndex::getPackageData(const PackageId &id) const
+{
+    auto v = findVersion(id);
+    if (!v)
+        throw SW_RUNTIME_ERROR("No such package in db: " + id.toString());
+
+    PackageData d;
+    d.hash = getString(v->hash);
+    d.flags = v->flags;
+    d.group_number = v->group_number;
+    d.prefix = v->prefix;
+    for (auto dep = deps + v->first_dep; dep != deps + v->first_dep + v->n_deps; dep++)
+    {
+        d.dependencies.emplace(
+            String(getString(packages[dep->package].path)),
+            String(getString(dep->range)));
+    }
+    return d;
+}
+
+std::vector<PackagePath> PackagesIndex::getMatchingPackages(const String &name) const
+{
+    // same as sql 'like' - case insensitive
+    auto n = to_lower(name);
+    std::vector<PackagePath> r;
+    for (auto p = packages; p != packages + header->n_packages; p++)
+    {
+        if (n.empty() || getString(p->path_lower).find(n) != std::string_view::npos)
+            r.push_back(String(getString(p->path)));
+    }
+    return r;
+}
+
+std::vector<Version> PackagesIndex::getVersionsForPackage(const PackagePath &ppath) const
+{
+    std::vector<Version> r;
+    auto p = findPackage(ppath);
+    if (!p)
+        return r;
+    for (auto v = versions + p->first_version; v != versions + p->first_version + p->n_versions; v++)
+        r.push_back(String(getString(v->version)));
+    return r;
+}
+
+}
@@ -0,0 +1,59 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "package.h"
+
+#include <sw/support/filesystem.h>
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace sw
+{
+
+struct MappedFile;
+struct PackagesDatabase;
+
+/// Immutable binary snapshot of a packages database.
+/// Packages are sorted by lower case path, so lookups are binary searches
+/// over the mapped file and do not need any locking.
+/// Overridden dirs (sdir) are not stored, so this is for remote dbs only.
+struct SW_MANAGER_API PackagesIndex
+{
+    /// maps existing index, throws on bad or incompatible file
+    PackagesIndex(const path &fn);
+    PackagesIndex(const PackagesIndex &) = delete;
+    PackagesIndex &operator=(const PackagesIndex &) = delete;
+    ~PackagesIndex();
+
+    /// dumps the whole db into the index file
+    static void write(const PackagesDatabase &, const path &fn, int64_t db_version);
+
+    /// version of remote db the index was built from
+    int64_t getDatabaseVersion() const;
+
+    std::unordered_map<UnresolvedPackage, PackageId> resolve(const UnresolvedPackages &pkgs, UnresolvedPackages &unresolved_pkgs) const;
+    PackageData getPackageData(const PackageId &) const;
+    std::vector<PackagePath> getMatchingPackages(const String &name = {}) const;
+    std::vector<Version> getVersionsForPackage(const PackagePath &) const;
+
+private:
+    std::unique_ptr<MappedFile> f;
+    const struct PackagesIndexHeader *header = nullptr;
+    const struct PackagesIndexPackage *packages = nullptr;
+    const struct PackagesIndexVersion *versions = nullptr;
+    const struct PackagesIndexDependency *deps = nullptr;
+    const char *strings = nullptr;
+
+    std::string_view getString(const struct PackagesIndexString &) const;
+    const PackagesIndexPackage *findPackage(const PackagePath &) const;
+    const PackagesIndexVersion *findVersion(const PackageId &) const;
+};
+
+}
@@ -8,8 +8,12 @@
 
 #include "database.h"
 
+#include <primitives/executor.h>
 #include <primitives/pack.h>
 
+#include <condition_variable>
+#include <thread>
+
 #include <primitives/log.h>
 DECLARE_STATIC_LOGGER(logger, "storage");
 
@@ -244,8 +248,28 @@ PackagesDatabase &StorageWithPackagesDatabase::getPackagesDatabase() const
 std::unordered_map<UnresolvedPackage, PackagePtr>
 StorageWithPackagesDatabase::resolve(const UnresolvedPackages &pkgs, UnresolvedPackages &unresolved_pkgs) const
 {
+    auto resolved = pkgdb->resolve(pkgs, unresolved_pkgs);
+
+    // prefetch data for all resolved packages at once,
+    // they are requested right after resolving
+    std::vector<PackageId> missing;
+    {
+        std::lock_guard lk(m);
+        for (auto &[ud, pkg] : resolved)
+        {
+            if (data.find(pkg) == data.end())
+                missing.push_back(pkg);
+        }
+    }
+    if (!missing.empty())
+    {
+        auto d = pkgdb->getPackageData(missing);
+        std::lock_guard lk(m);
+        data.merge(d);
+    }
+
     std::unordered_map<UnresolvedPackage, PackagePtr> r;
-    for (auto &[ud, pkg] : pkgdb->resolve(pkgs, unresolved_pkgs))
+    for (auto &[ud, pkg] : resolved)
         r.emplace(ud, std::make_unique<Package>(*this, pkg));
     return r;
 }
@@ -419,23 +443,95 @@ LocalPackage LocalStorage::install(const Package &id) const
     return p;
 }
 
-void LocalStorage::get(const IStorage2 &source, const PackageId &id, StorageFileType t) const
+namespace
 {
-    LocalPackage lp(*this, id);
 
-    path dst;
+struct Semaphore
+{
+    Semaphore(int n) : n(n) {}
+
+    void lock()
+    {
+        std::unique_lock lk(m);
+        cv.wait(lk, [this] { return n > 0; });
+        n--;
+    }
+
+    void unlock()
+    {
+        {
+            std::unique_lock lk(m);
+            n++;
+        }
+        cv.notify_one();
+    }
+
+private:
+    int n;
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+}
+
+void LocalStorage::install(const std::vector<const Package *> &pkgs) const
+{
+    // downloads are network bound, unpacks are disk bound,
+    // so we limit them separately and let them overlap
+    static const int max_downloads = 8;
+    static const int max_unpacks = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+    Semaphore downloads(max_downloads);
+    Semaphore unpacks(max_unpacks);
+
+    auto &e = getExecutor();
+    Futures<void> futures;
+    for (auto p : pkgs)
+    {
+        if (isPackageInstalled(*p) || isPackageOverridden(*p))
+            continue;
+        futures.push_back(e.push([this, p, &downloads, &unpacks]
+        {
+            auto t = StorageFileType::SourceArchive;
+            auto dst = getDownloadFilename(*p, t);
+            SCOPE_EXIT
+            {
+                error_code ec;
+                fs::remove(dst, ec);
+            };
+
+            std::unique_ptr<vfs::File> f;
+            {
+                std::lock_guard lk(downloads);
+                f = download(static_cast<const IStorage2 &>(p->getStorage()), *p, t, dst);
+            }
+            {
+                std::lock_guard lk(unpacks);
+                unpack(*f, *p, t, dst);
+            }
+            getPackagesDatabase().installPackage(*p, p->getData());
+        }));
+    }
+    waitAndGet(futures);
+}
+
+path LocalStorage::getDownloadFilename(const PackageId &id, StorageFileType t) const
+{
+    LocalPackage lp(*this, id);
     switch (t)
     {
     case StorageFileType::SourceArchive:
-        dst = lp.getDir() / make_archive_name();
+        return lp.getDir() / make_archive_name();
         //dst += ".new"; // without this storage can be left in inconsistent state
-        break;
+    default:
+        SW_UNREACHABLE;
     }
+}
 
-    LOG_INFO(logger, "Downloading: [" + id.toString() + "]/[" + toUserString(t) + "]");
-    auto f = source.getFile(id, t);
-    if (!f->copy(dst))
-        throw SW_RUNTIME_ERROR("Error downloading file for package: " + id.toString() + ", file: " + toUserString(t));
+void LocalStorage::get(const IStorage2 &source, const PackageId &id, StorageFileType t) const
+{
+    auto dst = getDownloadFilename(id, t);
+    auto f = download(source, id, t, dst);
 
     SCOPE_EXIT
     {
@@ -444,6 +540,22 @@ void LocalStorage::get(const IStorage2 &source, const PackageId &id, StorageFile
         fs::remove(dst);
     };
 
+    unpack(*f, id, t, dst);
+}
+
+std::unique_ptr<vfs::File> LocalStorage::download(const IStorage2 &source, const PackageId &id, StorageFileType t, const path &dst) const
+{
+    LOG_INFO(logger, "Downloading: [" + id.toString() + "]/[" + toUserString(t) + "]");
+    auto f = source.getFile(id, t);
+    if (!f->copy(dst))
+        throw SW_RUNTIME_ERROR("Error downloading file for package: " + id.toString() + ", file: " + toUserString(t));
+    return f;
+}
+
+void LocalStorage::unpack(const vfs::File &f, const PackageId &id, StorageFileType t, const path &dst) const
+{
+    LocalPackage lp(*this, id);
+
     auto unpack = [&id, &dst, &lp, &t]()
     {
         for (auto &d : fs::directory_iterator(lp.getDir()))
@@ -458,7 +570,7 @@ void LocalStorage::get(const IStorage2 &source, const PackageId &id, StorageFile
 
     // at the moment we perform check after download
     // but maybe we can move it before real download?
-    if (auto fh = dynamic_cast<const vfs::FileWithHashVerification *>(f.get()))
+    if (auto fh = dynamic_cast<const vfs::FileWithHashVerification *>(&f))
     {
         if (fh->getHash() == lp.getStampHash())
         {
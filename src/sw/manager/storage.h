@@ -242,6 +242,10 @@ struct SW_MANAGER_API LocalStorage : Directories, LocalStorageBase
     //LocalPackage download(const PackageId &) const override;
     void remove(const LocalPackage &) const;
     LocalPackage install(const Package &) const override;
+    /// installs many packages at once:
+    /// downloads and unpacks of different packages overlap,
+    /// the number of concurrent network and disk operations is bounded
+    void install(const std::vector<const Package *> &) const;
     LocalPackage installLocalPackage(const PackageId &, const PackageData &);
     void get(const IStorage2 &source, const PackageId &id, StorageFileType) const /* override*/;
     bool isPackageInstalled(const Package &id) const;
@@ -260,6 +264,11 @@ private:
     OverriddenPackagesStorage ovs;
 
     void migrateStorage(int from, int to);
+
+    // get() stages
+    std::unique_ptr<vfs::File> download(const IStorage2 &source, const PackageId &id, StorageFileType, const path &dst) const;
+    void unpack(const vfs::File &, const PackageId &id, StorageFileType, const path &dst) const;
+    path getDownloadFilename(const PackageId &id, StorageFileType) const;
 };
 
 struct CachedStorage : IStorage
@@ -8,6 +8,7 @@
 
 #include "api.h"
 #include "database.h"
+#include "packages_index.h"
 #include "settings.h"
 
 #include <primitives/command.h>
@@ -19,6 +20,7 @@
 #include <sqlpp11/sqlite3/connection.h>
 
 #include <fstream>
+#include <string_view>
 
 #include <primitives/log.h>
 DECLARE_STATIC_LOGGER(logger, "storage");
@@ -29,6 +31,8 @@ DECLARE_STATIC_LOGGER(logger, "storage");
 #define PACKAGES_DB_SCHEMA_VERSION_FILE "schema.version"
 #define PACKAGES_DB_VERSION_FILE "db.version"
 #define PACKAGES_DB_DOWNLOAD_TIME_FILE "packages.time"
+#define PACKAGES_DB_INDEX_FILE "packages.index"
+#define PACKAGES_DB_IMPORTED_DIR "imported"
 
 const String db_repo_name = "SoftwareNetwork/database";
 const String db_repo_url = "https://github.com/" + db_repo_name;
@@ -88,6 +92,9 @@ RemoteStorage::RemoteStorage(LocalStorage &ls, const Remote &r)
     if (!getPackagesDatabase().getIntValue(db_loaded_var))
     {
         LOG_DEBUG(logger, "Packages database was not found");
+        // nothing to diff against
+        error_code ec;
+        fs::remove_all(getPackagesDatabase().fn.parent_path() / PACKAGES_DB_IMPORTED_DIR, ec);
         download();
         load();
         getPackagesDatabase().setIntValue(db_loaded_var, 1);
@@ -97,6 +104,8 @@ RemoteStorage::RemoteStorage(LocalStorage &ls, const Remote &r)
 
     // at the end we always reopen packages db as read only
     getPackagesDatabase().open(true, true);
+
+    loadIndex();
 }
 
 RemoteStorage::~RemoteStorage() = default;
@@ -176,12 +185,117 @@ void RemoteStorage::download() const
     writeDownloadTime();
 }
 
-static std::istream &safe_getline(std::istream &i, String &s)
+namespace
+{
+
+// whole csv file in memory, lines point into it
+struct CsvFile
+{
+    String data;
+    std::vector<std::string_view> lines;
+
+    CsvFile(const path &fn)
+    {
+        if (!fs::exists(fn))
+            throw SW_RUNTIME_ERROR("Cannot open file " + fn.string() + " for reading");
+        data = read_file(fn);
+        std::string_view s = data;
+        while (!s.empty())
+        {
+            auto p = s.find('\n');
+            auto l = s.substr(0, p);
+            if (!l.empty() && l.back() == '\r')
+                l.remove_suffix(1);
+            lines.push_back(l);
+            if (p == s.npos)
+                break;
+            s.remove_prefix(p + 1);
+        }
+    }
+
+    std::string_view getHeader() const
+    {
+        return lines.empty() ? std::string_view{} : lines[0];
+    }
+};
+
+std::vector<std::string_view> split_csv_line(std::string_view s)
 {
-    std::getline(i, s);
-    if (!s.empty() && s.back() == '\r')
-        s.resize(s.size() - 1);
-    return i;
+    std::vector<std::string_view> r;
+    while (1)
+    {
+        auto p = s.find(',');
+        r.push_back(s.substr(0, p));
+        if (p == s.npos)
+            break;
+        s.remove_prefix(p + 1);
+    }
+    return r;
+}
+
+// changes of a single table between two imports
+struct TableDiff
+{
+    String table;
+    std::unique_ptr<CsvFile> new_file;
+    std::unique_ptr<CsvFile> old_file;
+    std::vector<String> cols;
+    std::vector<size_t> pk_cols;
+    bool full = false;
+    std::vector<std::string_view> upserts;
+    std::vector<std::vector<std::string_view>> deletes; // primary key values
+
+    void diff()
+    {
+        auto get_key = [this](const std::vector<std::string_view> &fields)
+        {
+            String k;
+            for (auto i : pk_cols)
+            {
+                if (i >= fields.size())
+                    throw SW_RUNTIME_ERROR("Bad csv line in table: " + table);
+                k.append(fields[i]);
+                k += '\0';
+            }
+            return k;
+        };
+
+        std::unordered_map<String, std::string_view> old_rows;
+        old_rows.reserve(old_file->lines.size());
+        for (size_t i = 1; i < old_file->lines.size(); i++)
+        {
+            auto &l = old_file->lines[i];
+            if (!l.empty())
+                old_rows.emplace(get_key(split_csv_line(l)), l);
+        }
+
+        for (size_t i = 1; i < new_file->lines.size(); i++)
+        {
+            auto &l = new_file->lines[i];
+            if (l.empty())
+                continue;
+            auto it = old_rows.find(get_key(split_csv_line(l)));
+            if (it == old_rows.end())
+            {
+                upserts.push_back(l);
+                continue;
+            }
+            if (it->second != l)
+                upserts.push_back(l);
+            old_rows.erase(it);
+        }
+
+        for (auto &[_, l] : old_rows)
+        {
+            auto fields = split_csv_line(l);
+            std::vector<std::string_view> pk;
+            for (auto i : pk_cols)
+                pk.push_back(fields[i]);
+            deletes.push_back(std::move(pk));
+        }
+    }
+};
+
 }
 
 void RemoteStorage::load() const
@@ -202,19 +316,17 @@ void RemoteStorage::load() const
     sdb.setPackagesDbSchemaVersion(sver);
     }*/
 
-    struct Column
+    static const Strings skip_cols
     {
-        String name;
-        bool skip = false;
+        "group_number",
     };
 
-    static const Strings skip_cols
+    auto is_skipped_column = [](const String &name)
     {
-        "group_number",
+        return std::find(skip_cols.begin(), skip_cols.end(), name) != skip_cols.end();
     };
 
     auto mdb = getPackagesDatabase().db->native_handle();
-    sqlite3_stmt *stmt = nullptr;
 
     // load only known tables
     // alternative: read csv filenames by mask and load all
@@ -234,112 +346,211 @@ void RemoteStorage::load() const
     if (rc != SQLITE_OK)
         throw SW_RUNTIME_ERROR("cannot query db for tables: " + getPackagesDatabase().fn.u8string());
 
-    getPackagesDatabase().db->execute("PRAGMA foreign_keys = OFF;");
-    getPackagesDatabase().db->execute("BEGIN;");
+    // csv files of the previous successful import,
+    // we diff against them and apply only changed rows
+    // in-memory db is thrown away on exit, so do not diff against it
+    auto imported_dir = getPackagesDatabase().fn.parent_path() / PACKAGES_DB_IMPORTED_DIR;
+    auto fn = sqlite3_db_filename(mdb, "main");
+    bool file_db = fn && *fn;
+
+    std::vector<TableDiff> diffs(data_tables.size());
+    for (size_t i = 0; i < data_tables.size(); i++)
+    {
+        auto &d = diffs[i];
+        d.table = data_tables[i];
+
+        std::set<String> pk;
+        rc = sqlite3_exec(mdb, ("PRAGMA table_info(" + d.table + ");").c_str(),
+            [](void *o, int n, char **cols, char **names)
+            {
+                // pk column is non zero for primary key columns
+                String name;
+                bool is_pk = false;
+                for (int i = 0; i < n; i++)
+                {
+                    if (strcmp(names[i], "name") == 0)
+                        name = cols[i];
+                    if (strcmp(names[i], "pk") == 0)
+                        is_pk = cols[i] && strcmp(cols[i], "0") != 0;
+                }
+                if (is_pk)
+                    ((std::set<String> *)o)->insert(name);
+                return 0;
+            }, &pk, 0);
+        if (rc != SQLITE_OK)
+            throw SW_RUNTIME_ERROR("cannot query table info: " + d.table);
+
+        d.new_file = std::make_unique<CsvFile>(db_repo_dir / (d.table + ".csv"));
+        for (auto &c : split_csv_line(d.new_file->getHeader()))
+        {
+            if (pk.erase(String(c)))
+                d.pk_cols.push_back(d.cols.size());
+            d.cols.emplace_back(c);
+        }
+
+        auto old_fn = imported_dir / (d.table + ".csv");
+        d.full = !file_db || !pk.empty() || d.pk_cols.empty() || !fs::exists(old_fn);
+        if (!d.full)
+        {
+            d.old_file = std::make_unique<CsvFile>(old_fn);
+            d.full = d.old_file->getHeader() != d.new_file->getHeader();
+        }
+    }
+
+    // diff tables in parallel
+    auto &e = getExecutor();
+    Futures<void> futures;
+    for (auto &d : diffs)
+    {
+        if (!d.full)
+            futures.push_back(e.push([&d] { d.diff(); }));
+    }
+    waitAndGet(futures);
 
-    auto split_csv_line = [](auto &s)
+    auto prepare = [mdb](const String &query)
     {
-        std::replace(s.begin(), s.end(), ',', '\0');
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(mdb, query.c_str(), (int)query.size() + 1, &stmt, 0) != SQLITE_OK)
+            throw SW_RUNTIME_ERROR(sqlite3_errmsg(mdb));
+        return stmt;
     };
 
-    for (auto &td : data_tables)
+    auto step = [mdb](sqlite3_stmt *stmt)
     {
-        getPackagesDatabase().db->execute("delete from " + td);
+        auto rc = sqlite3_step(stmt);
+        if (rc != SQLITE_DONE)
+            throw SW_RUNTIME_ERROR("sqlite3_step() failed: "s + sqlite3_errmsg(mdb));
+        rc = sqlite3_reset(stmt);
+        if (rc != SQLITE_OK)
+            throw SW_RUNTIME_ERROR("sqlite3_reset() failed: "s + sqlite3_errmsg(mdb));
+    };
 
-        auto fn = db_repo_dir / (td + ".csv");
-        std::ifstream ifile(fn);
-        if (!ifile)
-            throw SW_RUNTIME_ERROR("Cannot open file " + fn.string() + " for reading");
+    auto finalize = [mdb](sqlite3_stmt *stmt)
+    {
+        if (sqlite3_finalize(stmt) != SQLITE_OK)
+            throw SW_RUNTIME_ERROR("sqlite3_finalize() failed: "s + sqlite3_errmsg(mdb));
+    };
 
-        String s;
-        int rc;
+    auto bind = [](sqlite3_stmt *stmt, int col, std::string_view v)
+    {
+        if (!v.empty())
+            sqlite3_bind_text(stmt, col, v.data(), (int)v.size(), SQLITE_TRANSIENT);
+        else
+            sqlite3_bind_null(stmt, col);
+    };
 
-        // read first line
-        safe_getline(ifile, s);
-        split_csv_line(s);
+    getPackagesDatabase().db->execute("PRAGMA foreign_keys = OFF;");
+    getPackagesDatabase().db->execute("BEGIN;");
 
-        auto is_skipped_column = [](const String &name)
+    for (auto &d : diffs)
+    {
+        if (d.full)
         {
-            return std::find_if(skip_cols.begin(), skip_cols.end(), [&name](const auto &col)
+            getPackagesDatabase().db->execute("delete from " + d.table);
+            for (size_t i = 1; i < d.new_file->lines.size(); i++)
             {
-                return col == name;
-            }) != skip_cols.end();
-        };
+                if (!d.new_file->lines[i].empty())
+                    d.upserts.push_back(d.new_file->lines[i]);
+            }
+        }
 
-        // read fields
-        auto b = s.c_str();
-        auto e = &s.back() + 1;
-        std::vector<Column> cols;
-        cols.push_back({ b });
-        if (is_skipped_column(cols.back().name))
-            cols.back().skip = true;
-        while (1)
+        LOG_DEBUG(logger, "Importing " + d.table + (d.full ? " (full)" : "") + ": "
+            << d.upserts.size() << " inserted or updated, " << d.deletes.size() << " deleted rows");
+
+        if (!d.deletes.empty())
         {
-            if (b == e)
-                break;
-            if (*b++ == 0)
+            String query = "delete from " + d.table + " where ";
+            for (auto i : d.pk_cols)
+                query += d.cols[i] + " = ? and ";
+            query.resize(query.size() - 5);
+            query += ";";
+
+            auto stmt = prepare(query);
+            for (auto &pk : d.deletes)
             {
-                cols.push_back({ b });
-                if (is_skipped_column(cols.back().name))
-                    cols.back().skip = true;
+                for (size_t i = 0; i < pk.size(); i++)
+                    bind(stmt, (int)i + 1, pk[i]);
+                step(stmt);
             }
+            finalize(stmt);
         }
-        auto n_cols = cols.size();
 
-        // add only them
-        String query = "insert into " + td + " (";
-        for (auto &c : cols)
+        if (d.upserts.empty())
+            continue;
+
+        // add only known columns
+        String query = "insert or replace into " + d.table + " (";
+        for (auto &c : d.cols)
         {
-            if (!c.skip)
-                query += c.name + ", ";
+            if (!is_skipped_column(c))
+                query += c + ", ";
         }
         query.resize(query.size() - 2);
         query += ") values (";
-        for (size_t i = 0; i < n_cols; i++)
+        for (auto &c : d.cols)
         {
-            if (!cols[i].skip)
+            if (!is_skipped_column(c))
                 query += "?, ";
         }
         query.resize(query.size() - 2);
         query += ");";
 
-        if (sqlite3_prepare_v2(mdb, query.c_str(), (int)query.size() + 1, &stmt, 0) != SQLITE_OK)
-            throw SW_RUNTIME_ERROR(sqlite3_errmsg(mdb));
-
-        while (safe_getline(ifile, s))
+        auto stmt = prepare(query);
+        for (auto &l : d.upserts)
         {
-            auto b = s.c_str();
-            split_csv_line(s);
-
-            for (int i = 1, col = 1; i <= n_cols; i++)
+            auto fields = split_csv_line(l);
+            for (size_t i = 0, col = 1; i < d.cols.size(); i++)
             {
-                if (!cols[i - 1].skip)
-                {
-                    if (*b)
-                        sqlite3_bind_text(stmt, col, b, -1, SQLITE_TRANSIENT);
-                    else
-                        sqlite3_bind_null(stmt, col);
-                    col++;
-                }
-
-                // skip ahead
-                while (*b++);
+                if (is_skipped_column(d.cols[i]))
+                    continue;
+                bind(stmt, (int)col++, i < fields.size() ? fields[i] : std::string_view{});
             }
-
-            rc = sqlite3_step(stmt);
-            if (rc != SQLITE_DONE)
-                throw SW_RUNTIME_ERROR("sqlite3_step() failed: "s + sqlite3_errmsg(mdb));
-            rc = sqlite3_reset(stmt);
-            if (rc != SQLITE_OK)
-                throw SW_RUNTIME_ERROR("sqlite3_reset() failed: "s + sqlite3_errmsg(mdb));
+            step(stmt);
         }
-
-        if (sqlite3_finalize(stmt) != SQLITE_OK)
-            throw SW_RUNTIME_ERROR("sqlite3_finalize() failed: "s + sqlite3_errmsg(mdb));
+        finalize(stmt);
     }
 
     getPackagesDatabase().db->execute("COMMIT;");
     getPackagesDatabase().db->execute("PRAGMA foreign_keys = ON;");
+
+    // remember what we've imported
+    error_code ec;
+    fs::remove_all(imported_dir, ec);
+    if (!file_db)
+        return;
+    fs::create_directories(imported_dir);
+    for (auto &d : diffs)
+        fs::copy_file(db_repo_dir / (d.table + ".csv"), imported_dir / (d.table + ".csv"), fs::copy_options::overwrite_existing);
+}
+
+void RemoteStorage::loadIndex(bool rebuild) const
+{
+    auto fn = getPackagesDatabase().fn.parent_path() / PACKAGES_DB_INDEX_FILE;
+    auto version = readPackagesDbVersion(db_repo_dir);
+    try
+    {
+        std::shared_ptr<PackagesIndex> i;
+        if (!rebuild && fs::exists(fn))
+            i = std::make_shared<PackagesIndex>(fn);
+        if (!i || i->getDatabaseVersion() != version)
+        {
+            i.reset();
+            PackagesIndex::write(getPackagesDatabase(), fn, version);
+            i = std::make_shared<PackagesIndex>(fn);
+        }
+        // old index may be still in use by other process, so it was not replaced
+        if (i->getDatabaseVersion() != version)
+        {
+            LOG_DEBUG(logger, "Packages index is outdated, using packages db");
+            return;
+        }
+        getPackagesDatabase().setIndex(i);
+    }
+    catch (std::exception &e)
+    {
+        // sqlite db is still usable
+        LOG_DEBUG(logger, "Cannot load packages index: " << e.what());
+    }
 }
 
 void RemoteStorage::updateDb() const
@@ -370,6 +581,8 @@ void RemoteStorage::updateDb() const
             download();
             load();
         });
+        getPackagesDatabase().clearCache();
+        loadIndex(true);
     }
 }
 
@@ -428,6 +641,34 @@ bool RemoteStorage::isCurrentDbOld() const
     return p;
 }*/
 
+// file://[localhost]/path, file:///C:/path
+static path file_url_to_path(const String &url)
+{
+    auto s = url.substr(7);
+    if (s.find("localhost/") == 0)
+        s = s.substr(9);
+
+    String r;
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if (s[i] == '%' && i + 2 < s.size() && isxdigit((unsigned char)s[i + 1]) && isxdigit((unsigned char)s[i + 2]))
+        {
+            r += (char)std::stoi(s.substr(i + 1, 2), nullptr, 16);
+            i += 2;
+        }
+        else
+            r += s[i];
+    }
+
+    // drive letter
+    if (r.size() > 2 && r[0] == '/' && isalpha((unsigned char)r[1]) && (r[2] == ':' || r[2] == '|'))
+    {
+        r = r.substr(1);
+        r[1] = ':';
+    }
+    return fs::u8path(r);
+}
+
 struct RemoteFileWithHashVerification : vfs::FileWithHashVerification
 {
     Strings urls;
@@ -488,7 +729,11 @@ struct RemoteFileWithHashVerification : vfs::FileWithHashVerification
             try
             {
                 LOG_TRACE(logger, "Downloading file: " << url);
-                download_file(url, fn);
+                // local mirrors
+                if (url.find("file://") == 0)
+                    fs::copy_file(file_url_to_path(url), fn, fs::copy_options::overwrite_existing);
+                else
+                    download_file(url, fn);
             }
             catch (std::exception &e)
             {
@@ -552,6 +797,10 @@ RemoteStorageWithFallbackToRemoteResolving::resolve(const UnresolvedPackages &pk
     if (unresolved_pkgs.empty())
         return m;
 
+    // we are called with many packages at once,
+    // so ask remote only for what is missing locally
+    auto upkgs = std::move(unresolved_pkgs);
+
     // clear dirty output
     unresolved_pkgs.clear();
 
@@ -560,17 +809,17 @@ RemoteStorageWithFallbackToRemoteResolving::resolve(const UnresolvedPackages &pk
     try
     {
         // fallback to really remote db
-        return resolveFromRemote(pkgs, unresolved_pkgs);
+        m.merge(resolveFromRemote(upkgs, unresolved_pkgs));
     }
     catch (std::exception &e)
     {
         // we ignore remote storage errors, print them,
-        // mark all deps as unresolved and
-        // return empty result
+        // mark missing deps as unresolved and
+        // return what we have
         LOG_TRACE(logger, e.what());
-        unresolved_pkgs = pkgs;
-        return {};
+        unresolved_pkgs = upkgs;
     }
+    return m;
 }
 
 std::unordered_map<UnresolvedPackage, PackagePtr>
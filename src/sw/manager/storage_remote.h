@@ -35,6 +35,7 @@ private:
 
     void download() const;
     void load() const;
+    void loadIndex(bool rebuild = false) const;
     void updateDb() const;
     void preInitFindDependencies() const;
     void writeDownloadTime() const;
@@ -93,48 +93,53 @@ std::unordered_map<UnresolvedPackage, PackagePtr> SwManagerContext::resolve(cons
     auto upkgs = in_pkgs;
     while (1)
     {
-        std::unordered_map<UnresolvedPackage, PackagePtr> resolved_step;
+        // resolve the whole frontier at once, one call per storage
+        UnresolvedPackages frontier;
         for (auto &p : upkgs)
         {
-            if (resolved.find(p) != resolved.end())
-                continue;
+            if (resolved.find(p) == resolved.end())
+                frontier.insert(p);
+        }
+        if (frontier.empty())
+            break;
 
-            // select the best candidate from all storages first
-            // (later we'll have security selector also - what signature matches)
+        // select the best candidate from all storages first
+        // (later we'll have security selector also - what signature matches)
 
-            PackagePtr pkg;
-            for (const auto &[i, s] : enumerate(storages))
+        std::unordered_map<UnresolvedPackage, PackagePtr> resolved_step;
+        for (const auto &[i, s] : enumerate(storages))
+        {
+            if (frontier.empty())
+                break;
+
+            UnresolvedPackages unresolved;
+            for (auto &[p, pkg] : s->resolve(frontier, unresolved))
             {
-                UnresolvedPackages unresolved;
-                auto r = s->resolve({ p }, unresolved);
-                if (r.empty())
-                    continue; // not found in this storage
+                auto &best = resolved_step[p];
                 if (p.getRange().isBranch())
                 {
                     // when we found a branch, we stop, because following storages cannot give us more preferable branch
                     // TODO: change this when security is on
                     // (following storages cold give us suitable (signed) branch)
-                    pkg = std::move(r.begin()->second);
-                    break;
-                }
-                if (!pkg || r.begin()->second->getVersion() > pkg->getVersion())
-                {
-                    pkg = std::move(r.begin()->second);
+                    best = std::move(pkg);
+                    frontier.erase(p);
+                    continue;
                 }
-                if (pkg && i == cache_storage_id)
+                if (!best || pkg->getVersion() > best->getVersion())
+                    best = std::move(pkg);
+                if (i == cache_storage_id)
                 {
                     // cache hit, we stop immediately
-                    break;
+                    frontier.erase(p);
                 }
             }
-            if (!pkg)
-                throw SW_RUNTIME_ERROR("Package '" + p.toString() + "' is not resolved");
-
-            resolved_step[p] = std::move(pkg);
         }
 
-        if (resolved_step.empty())
-            break;
+        for (auto &p : upkgs)
+        {
+            if (resolved.find(p) == resolved.end() && resolved_step.find(p) == resolved_step.end())
+                throw SW_RUNTIME_ERROR("Package '" + p.toString() + "' is not resolved");
+        }
 
         // gather deps
         upkgs.clear(); // clear current unresolved pkgs
@@ -156,17 +161,14 @@ std::unordered_map<UnresolvedPackage, LocalPackage> SwManagerContext::install(co
 
     // two unresolved pkgs may point to single pkg,
     // so make pkgs unique
-    std::unordered_map<PackageId, Package*> pkgs2;
+    std::unordered_map<PackageId, const Package*> pkgs2;
     for (auto &[u, p] : m)
         pkgs2.emplace(*p, p.get());
 
-    auto &e = getExecutor();
-    Futures<void> fs;
-    for (auto &p : pkgs2)
-    {
-        fs.push_back(e.push([this, &p] { install(*p.second); }));
-    }
-    waitAndGet(fs);
+    std::vector<const Package *> pkgs4;
+    for (auto &[_, p] : pkgs2)
+        pkgs4.push_back(p);
+    getLocalStorage().install(pkgs4);
 
     // install should be fast enough here
     std::unordered_map<UnresolvedPackage, LocalPackage> pkgs3;
@@ -0,0 +1,45 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "mmap.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <primitives/exceptions.h>
+
+namespace sw
+{
+
+namespace bip = boost::interprocess;
+
+struct MappedFileImpl
+{
+    bip::file_mapping m;
+    bip::mapped_region r;
+};
+
+MappedFile::MappedFile(const path &fn)
+{
+    // empty files cannot be mapped
+    if (fs::file_size(fn) == 0)
+        return;
+    try
+    {
+        impl = std::make_unique<MappedFileImpl>();
+        impl->m = bip::file_mapping(fn.string().c_str(), bip::read_only);
+        impl->r = bip::mapped_region(impl->m, bip::read_only);
+    }
+    catch (bip::interprocess_exception &e)
+    {
+        throw SW_RUNTIME_ERROR("Cannot map file " + normalize_path(fn) + ": " + e.what());
+    }
+    p = (const uint8_t *)impl->r.get_address();
+    sz = impl->r.get_size();
+}
+
+MappedFile::~MappedFile() = default;
+
+}
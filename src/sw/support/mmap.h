@@ -0,0 +1,33 @@
+// Copyright (C) 2019 Egor Pugin <egor.pugin@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <primitives/filesystem.h>
+
+#include <memory>
+
+namespace sw
+{
+
+// read only mapping of the whole file
+struct SW_SUPPORT_API MappedFile
+{
+    MappedFile(const path &fn);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    const uint8_t *data() const { return p; }
+    size_t size() const { return sz; }
+
+private:
+    std::unique_ptr<struct MappedFileImpl> impl;
+    const uint8_t *p = nullptr;
+    size_t sz = 0;
+};
+
+}
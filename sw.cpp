@@ -22,6 +22,7 @@ void build(Solution &s)
             "pub.egorpugin.primitives.symbol-master"_dep,
             "org.sw.demo.boost.property_tree"_dep,
             "org.sw.demo.boost.stacktrace"_dep;
+        support += "org.sw.demo.boost.interprocess"_dep;
         //cmddep->getSettings()["export-if-static"] = "true";
         //cmddep->getSettings()["export-if-static"].setRequired();
         support.ApiName = "SW_SUPPORT_API";
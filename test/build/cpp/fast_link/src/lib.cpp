@@ -0,0 +1,9 @@
+#include "lib.h"
+
+std::string fast_link_message(int n)
+{
+    std::string s;
+    for (int i = 0; i < n; i++)
+        s += std::to_string(i * i) + " ";
+    return s;
+}
@@ -0,0 +1,9 @@
+#include "lib.h"
+
+#include <iostream>
+
+int main()
+{
+    std::cout << fast_link_message(10) << "\n";
+    return 3;
+}
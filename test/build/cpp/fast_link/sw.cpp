@@ -0,0 +1,9 @@
+void build(Solution &s)
+{
+    auto &lib = s.addStaticLibrary("lib");
+    lib += "src/lib.cpp";
+
+    auto &exe = s.addExecutable("exe");
+    exe += "src/main.cpp";
+    exe += lib;
+}
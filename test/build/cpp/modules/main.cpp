@@ -0,0 +1,6 @@
+import math;
+
+int main()
+{
+    return add(1, 2) == 3 ? 0 : 1;
+}
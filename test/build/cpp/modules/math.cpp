@@ -0,0 +1,3 @@
+export module math;
+
+export int add(int a, int b);
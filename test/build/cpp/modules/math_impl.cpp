@@ -0,0 +1,6 @@
+module math;
+
+int add(int a, int b)
+{
+    return a + b;
+}
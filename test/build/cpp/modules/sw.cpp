@@ -0,0 +1,13 @@
+void build(Solution &s)
+{
+    // math.cpp is an interface unit, changes in math_impl.cpp do not rebuild main.cpp
+    auto &lib = s.addStaticLibrary("math");
+    lib.UseModules = true;
+    lib += "math.cpp";
+    lib += "math_impl.cpp";
+
+    auto &exe = s.addExecutable("main");
+    exe.UseModules = true;
+    exe += "main.cpp";
+    exe += lib;
+}
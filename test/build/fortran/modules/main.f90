@@ -0,0 +1,5 @@
+program main
+    use report
+    implicit none
+    call print_area(2.0)
+end program main
@@ -0,0 +1,9 @@
+module report
+    use shapes
+    implicit none
+contains
+    subroutine print_area(r)
+        real, intent(in) :: r
+        print *, 'area: ', circle_area(r)
+    end subroutine
+end module report
@@ -0,0 +1,9 @@
+module shapes
+    implicit none
+    real, parameter :: pi = 3.14159
+contains
+    real function circle_area(r)
+        real, intent(in) :: r
+        circle_area = pi * r * r
+    end function
+end module shapes
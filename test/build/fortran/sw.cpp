@@ -2,4 +2,9 @@ void build(Solution &s)
 {
     auto &f = s.addTarget<FortranExecutable>("main.fortran");
     f += "main.f";
+
+    // modules: report.f90 and main.f90 wait for .mod files of their dependencies
+    auto &m = s.addTarget<FortranExecutable>("main.fortran.modules");
+    m.setRootDirectory("modules");
+    m += ".*\\.f90"_rr;
 }
@@ -4,5 +4,6 @@ public class App
     {
         var hw = new HelloWorld();
         hw.print();
+        System.out.println(new greet.Greeter().greet("sw"));
     }
 }
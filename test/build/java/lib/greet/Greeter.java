@@ -0,0 +1,9 @@
+package greet;
+
+public class Greeter
+{
+    public String greet(String name)
+    {
+        return "Hello, " + name + "!";
+    }
+}
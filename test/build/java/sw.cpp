@@ -1,5 +1,11 @@
 void build(Solution &s)
 {
+    // users are not recompiled when only method bodies of the library change
+    auto &lib = s.addTarget<JavaTarget>("lib.java");
+    lib.setRootDirectory("lib");
+    lib += ".*\\.java"_rr;
+
     auto &j = s.addTarget<JavaExecutable>("main.java");
     j += ".*\\.java"_r;
+    j += lib;
 }
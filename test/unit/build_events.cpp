@@ -0,0 +1,130 @@
+#include <sw/builder/build_events.h>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+struct TestConsumer : BuildEventConsumer
+{
+    std::vector<size_t> events;
+    bool flushed = false;
+
+    void onEvent(const BuildEvent &e) override
+    {
+        events.push_back(e.index);
+    }
+
+    void flush() override
+    {
+        flushed = true;
+    }
+};
+
+TEST_CASE("Checking build events", "[build_events]")
+{
+    const int n_threads = 8;
+    const int n_events = 10000;
+
+    // small ring to make producers wait
+    BuildEvents be(8);
+    auto c = std::make_unique<TestConsumer>();
+    auto &tc = *c;
+    be.addConsumer(std::move(c));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++)
+    {
+        threads.emplace_back([&be, t]
+        {
+            for (int i = 0; i < n_events; i++)
+            {
+                BuildEvent e;
+                e.index = t * n_events + i;
+                be.push(std::move(e));
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    be.flush();
+
+    REQUIRE(tc.flushed);
+    REQUIRE(tc.events.size() == n_threads * n_events);
+
+    // events of every producer are consumed in order
+    std::vector<int> last(n_threads, -1);
+    for (auto i : tc.events)
+    {
+        auto t = i / n_events;
+        REQUIRE(i % n_events == last[t] + 1);
+        last[t] = i % n_events;
+    }
+}
+
+struct ClosingConsumer : BuildEventConsumer
+{
+    size_t &n;
+    bool &closed;
+
+    ClosingConsumer(size_t &n, bool &closed) : n(n), closed(closed) {}
+    ~ClosingConsumer() { closed = true; }
+
+    void onEvent(const BuildEvent &e) override
+    {
+        n++;
+    }
+};
+
+TEST_CASE("Checking build events stop", "[build_events]")
+{
+    const int n_events = 1000;
+
+    size_t n = 0;
+    bool closed = false;
+    BuildEvents be(8);
+    be.addConsumer(std::make_unique<ClosingConsumer>(n, closed));
+
+    for (int i = 0; i < n_events; i++)
+        be.push(BuildEvent{});
+    be.stop();
+
+    // pending events are consumed, consumers are closed
+    REQUIRE(n == n_events);
+    REQUIRE(closed);
+
+    // dropped
+    be.push(BuildEvent{});
+    be.flush();
+    be.stop();
+    REQUIRE(n == n_events);
+}
+
+TEST_CASE("Checking build events after idle", "[build_events]")
+{
+    size_t n = 0;
+    bool closed = false;
+    BuildEvents be(8);
+    be.addConsumer(std::make_unique<ClosingConsumer>(n, closed));
+
+    // consumer thread falls asleep between pushes and must be woken up
+    for (int i = 0; i < 10; i++)
+    {
+        be.push(BuildEvent{});
+        be.flush();
+        REQUIRE(n == i + 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    // idle consumer is woken up on stop
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    be.stop();
+    REQUIRE(closed);
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <configure_file.h>
+
+#include <map>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+static String configure(const String &text, const std::map<String, String> &vars, bool undef_replacements = true)
+{
+    auto t = ConfigureFileTemplate::get(text, undef_replacements);
+    ConfigureFileTemplate::Values values;
+    for (auto &v : t->getVariables())
+    {
+        auto i = vars.find(v);
+        if (i != vars.end())
+            values.push_back(i->second);
+        else
+            values.push_back({});
+    }
+    auto s = t->configure(values);
+    REQUIRE(s == t->render(values));
+    return s;
+}
+
+TEST_CASE("Checking configure file", "[configure_file]")
+{
+    std::map<String, String> vars{ {"A", "1"}, {"B", "x y"}, {"Z", "0"}, {"E", ""} };
+
+    SECTION("variables")
+    {
+        REQUIRE(configure("@A@ ${B} @N@", vars) == "1 x y ");
+        REQUIRE(configure("@@ @A ${A @A@@", vars) == "@@ @A ${A 1@");
+        // no recursive expansion
+        REQUIRE(configure("@R@", { {"R", "@A@"}, {"A", "1"} }) == "@A@");
+    }
+
+    SECTION("cmakedefine")
+    {
+        REQUIRE(configure("#cmakedefine A @B@\n", vars) == "#define A x y\n");
+        REQUIRE(configure("#cmakedefine Z rest\n", vars) == "/* #undef Z rest */\n");
+        REQUIRE(configure("#cmakedefine N\n", vars) == "/* #undef N */\n");
+        REQUIRE(configure("#cmakedefine E\r\n", vars) == "/* #undef E */\r\n");
+        REQUIRE(configure("#cmakedefine01 A\n#cmakedefine01 Z\n#cmakedefine01 N\n", vars) ==
+            "#define A 1\n#define Z 0\n#define N 0\n");
+        // unterminated line is left as is
+        REQUIRE(configure("#cmakedefine A", vars) == "#cmakedefine A");
+    }
+
+    SECTION("mesondefine")
+    {
+        REQUIRE(configure("  #mesondefine B\n#mesondefine N\n", vars) == "  #define B x y\n/* #undef N */\n");
+    }
+
+    SECTION("undef")
+    {
+        REQUIRE(configure("#undef A\n#undef Z\n#undef N\nx\n", vars) == "#define A 1\n/* # undef Z */\nx\n");
+        REQUIRE(configure("#undef A\n", vars, false) == "#undef A\n");
+    }
+
+    SECTION("memoization")
+    {
+        auto s = "#cmakedefine A\n@B@\n";
+        REQUIRE(configure(s, vars) == "#define A\nx y\n");
+        REQUIRE(ConfigureFileTemplate::get(s, true) == ConfigureFileTemplate::get(s, true));
+        vars["A"] = "0";
+        REQUIRE(configure(s, vars) == "/* #undef A */\nx y\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
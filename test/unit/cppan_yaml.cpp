@@ -0,0 +1,123 @@
+#include <frontend/cppan/yaml.h>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+static const String config = R"(
+version: 1.2.3
+source:
+    git: https://github.com/example/example
+    tag: v{v}
+
+common_settings:
+    c++: 17
+    include_directories:
+        - include
+
+projects:
+    lib:
+        type: library
+        files:
+            - src/.*\.cpp
+            - include/.*\.h
+        dependencies:
+            pvt.example.dep: "*"
+        options:
+            any:
+                definitions:
+                    public:
+                        - LIB_API=
+                        - EMPTY
+    exe:
+        type: executable
+        version: 0.0.1
+        files: main.cpp
+        dependencies:
+            - lib
+        empty:
+        quoted: "~"
+)";
+
+// styles and tags are not compared
+static bool same(const yaml &a, const yaml &b)
+{
+    if (a.Type() != b.Type() || a.size() != b.size())
+        return false;
+    if (a.IsScalar())
+        return a.Scalar() == b.Scalar();
+    if (a.IsSequence())
+    {
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (!same(a[i], b[i]))
+                return false;
+        }
+    }
+    if (a.IsMap())
+    {
+        auto i = a.begin();
+        auto j = b.begin();
+        for (; i != a.end(); ++i, ++j)
+        {
+            if (!same(i->first, j->first) || !same(i->second, j->second))
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("Checking cppan binary config", "[cppan_yaml]")
+{
+    auto root = cppan::load_yaml_config(config);
+
+    SECTION("round trip")
+    {
+        auto root2 = cppan::load_yaml_config_binary(cppan::save_yaml_config_binary(root));
+        REQUIRE(same(root2, root));
+        REQUIRE(root2["projects"]["exe"]["empty"].IsNull());
+        REQUIRE(root2["projects"]["lib"]["version"].as<String>() == "1.2.3");
+        REQUIRE(root2["projects"]["exe"]["quoted"].as<String>() == "~");
+
+        // normalization is a no-op for loaded configs
+        REQUIRE(same(cppan::load_yaml_config(root2), root));
+    }
+
+    SECTION("cache")
+    {
+        auto dir = fs::temp_directory_path() / "sw_test_cppan_yaml";
+        fs::remove_all(dir);
+
+        // uncached, then cached
+        REQUIRE(same(cppan::load_yaml_config_cached(config, dir), root));
+        REQUIRE(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 1);
+        REQUIRE(same(cppan::load_yaml_config_cached(config, dir), root));
+
+        // broken cache is replaced
+        for (auto &f : fs::directory_iterator(dir))
+            write_file(f.path(), "abcd");
+        REQUIRE(same(cppan::load_yaml_config_cached(config, dir), root));
+
+        // other contents get other entry
+        cppan::load_yaml_config_cached(config + "\nname: x\n", dir);
+        REQUIRE(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 2);
+
+        fs::remove_all(dir);
+    }
+
+    SECTION("errors")
+    {
+        REQUIRE_THROWS(cppan::load_yaml_config_binary("abcd"));
+        auto data = cppan::save_yaml_config_binary(root);
+        REQUIRE_THROWS(cppan::load_yaml_config_binary(data.substr(0, data.size() - 1)));
+        REQUIRE_THROWS(cppan::load_yaml_config_binary(data + "x"));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
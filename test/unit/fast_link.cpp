@@ -0,0 +1,148 @@
+#include <sw/builder/command.h>
+#include <sw/manager/version.h>
+#include <sw/support/filesystem.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <chrono>
+#include <iostream>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+// builds test/build/cpp/fast_link with sw from PATH (or SW_EXECUTABLE)
+
+static path get_sw()
+{
+    if (auto e = getenv("SW_EXECUTABLE"))
+        return e;
+    return "sw";
+}
+
+static String run(const path &wdir, const path &prog, const Strings &args, int expected_exit_code = 0)
+{
+    primitives::Command c;
+    c.working_directory = wdir;
+    c.setProgram(prog.is_absolute() ? prog : primitives::resolve_executable(prog));
+    for (auto &a : args)
+        c.push_back(a);
+    std::error_code ec;
+    c.execute(ec);
+    INFO(c.out.text + c.err.text);
+    REQUIRE(c.exit_code);
+    REQUIRE(c.exit_code.value() == expected_exit_code);
+    return c.out.text;
+}
+
+static sw::Version get_gcc_version()
+{
+    return sw::Version(boost::trim_copy(run(fs::current_path(), "gcc", { "-dumpfullversion" })));
+}
+
+static bool has_program(const String &p)
+{
+    return !primitives::resolve_executable(p).empty();
+}
+
+struct FastLinkBuild
+{
+    path dir;
+    String commands; // text of all executed commands
+    String output; // program output
+    int64_t ms = 0;
+
+    FastLinkBuild(const path &root, bool fast_link)
+    {
+        auto src = path(__FILE__).parent_path().parent_path() / "build" / "cpp" / "fast_link";
+        dir = root / (fast_link ? "fast" : "default");
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        fs::copy(src, dir, fs::copy_options::recursive);
+
+        Strings args{ "-compiler", "gcc", "-config", "rwdi", "-save-executed-commands" };
+        if (fast_link)
+            args.push_back("-fast-link");
+        args.push_back("build");
+
+        auto start = std::chrono::high_resolution_clock::now();
+        run(dir, get_sw(), args);
+        ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // saved commands and their response files, arguments are quoted
+        for (auto &f : fs::recursive_directory_iterator(dir / SW_BINARY_DIR / "rsp"))
+        {
+            if (fs::is_regular_file(f))
+                commands += read_file(f) + "\n";
+        }
+
+        for (auto &f : fs::recursive_directory_iterator(dir / SW_BINARY_DIR / "out"))
+        {
+            auto fn = f.path().filename().u8string();
+            if (fs::is_regular_file(f) && fn.find("exe") == 0 && f.path().extension() != ".dwo" &&
+                (fs::status(f).permissions() & fs::perms::owner_exec) != fs::perms::none)
+            {
+                output = run(dir, f.path(), {}, 3);
+                break;
+            }
+        }
+    }
+
+    bool has(const String &s) const
+    {
+        return commands.find(s) != commands.npos;
+    }
+};
+
+// run with: test.unit.fast_link [.benchmark]
+TEST_CASE("Benchmarking fast link", "[.benchmark]")
+{
+#ifndef __linux__
+    return;
+#endif
+
+    auto root = fs::temp_directory_path() / "sw_test_fast_link";
+    FastLinkBuild b(root, false);
+    FastLinkBuild fb(root, true);
+
+    // same program
+    REQUIRE(!b.output.empty());
+    REQUIRE(b.output == fb.output);
+
+    // default build does not change anything
+    REQUIRE(!b.has("-fuse-ld="));
+    REQUIRE(!b.has("-gsplit-dwarf"));
+    REQUIRE(!b.has("\"rcsT\""));
+
+    // debug info is split, archives are thin
+    REQUIRE(fb.has("-gsplit-dwarf"));
+    REQUIRE(fb.has("\"rcsT\""));
+    REQUIRE(!fb.has("\"rcs\""));
+
+    // mold (gcc 12.1+), then lld (gcc 9+)
+    auto v = get_gcc_version();
+    String ld;
+    if (has_program("ld.mold") && v >= sw::Version(12, 1))
+        ld = "mold";
+    else if (has_program("ld.lld") && v >= sw::Version(9))
+        ld = "lld";
+    if (ld.empty())
+    {
+        REQUIRE(!fb.has("-fuse-ld="));
+        REQUIRE(!fb.has("--gdb-index"));
+    }
+    else
+    {
+        REQUIRE(fb.has("-fuse-ld=" + ld));
+        REQUIRE(fb.has("--gdb-index"));
+    }
+
+    std::cout << "default build: " << b.ms << " ms, fast link build: " << fb.ms << " ms"
+        << (ld.empty() ? "" : ", linker: " + ld) << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
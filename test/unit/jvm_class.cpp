@@ -0,0 +1,159 @@
+#include <jvm_class.h>
+
+#include <vector>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+// writes minimal class files
+struct ClassWriter
+{
+    struct Member
+    {
+        uint16_t access;
+        String name;
+        String descriptor;
+        int constant = -1; // ConstantValue, int
+        String code; // Code attribute body
+    };
+
+    String name;
+    String super = "java/lang/Object";
+    std::vector<Member> fields;
+    std::vector<Member> methods;
+    String source_file;
+
+    String write() const
+    {
+        std::vector<String> pool;
+        String pool_data;
+        auto add = [&pool, &pool_data](const String &entry)
+        {
+            for (size_t i = 0; i < pool.size(); i++)
+            {
+                if (pool[i] == entry)
+                    return (uint16_t)(i + 1);
+            }
+            pool.push_back(entry);
+            pool_data += entry;
+            return (uint16_t)pool.size();
+        };
+        auto u2 = [](uint16_t v) { return String{ (char)(v >> 8), (char)(v & 0xff) }; };
+        auto u4 = [](uint32_t v) { return String{ (char)(v >> 24), (char)(v >> 16), (char)(v >> 8), (char)(v & 0xff) }; };
+        auto utf8 = [&](const String &s) { return add("\x01" + u2((uint16_t)s.size()) + s); };
+        auto cls = [&](const String &s) { return add("\x07" + u2(utf8(s))); };
+        auto integer = [&](int v) { return add("\x03" + u4(v)); };
+
+        String body;
+        body += u2(0x21);
+        body += u2(cls(name));
+        body += u2(cls(super));
+        body += u2(0); // interfaces
+        auto write_members = [&](const std::vector<Member> &members)
+        {
+            body += u2((uint16_t)members.size());
+            for (auto &m : members)
+            {
+                body += u2(m.access) + u2(utf8(m.name)) + u2(utf8(m.descriptor));
+                String attrs;
+                uint16_t n = 0;
+                if (m.constant != -1)
+                {
+                    attrs += u2(utf8("ConstantValue")) + u4(2) + u2(integer(m.constant));
+                    n++;
+                }
+                if (!m.code.empty())
+                {
+                    attrs += u2(utf8("Code")) + u4((uint32_t)m.code.size()) + m.code;
+                    n++;
+                }
+                body += u2(n) + attrs;
+            }
+        };
+        write_members(fields);
+        write_members(methods);
+        if (source_file.empty())
+            body += u2(0);
+        else
+            body += u2(1) + u2(utf8("SourceFile")) + u4(2) + u2(utf8(source_file));
+
+        return u4(0xCAFEBABE) + u2(0) + u2(52) + u2((uint16_t)(pool.size() + 1)) + pool_data + body;
+    }
+};
+
+TEST_CASE("Checking jvm class reader", "[jvm_class]")
+{
+    ClassWriter c;
+    c.name = "org/example/Foo";
+    c.source_file = "Foo.java";
+    c.fields.push_back({ 0x0001, "x", "Lorg/example/Bar;" });
+    c.fields.push_back({ 0x0019, "N", "I", 5 });
+    c.methods.push_back({ 0x0001, "f", "(Ljava/util/List;[Lorg/example/Baz;)V", -1, "body1" });
+    c.methods.push_back({ 0x0002, "g", "()Lorg/example/Private;", -1, "body2" });
+    auto i = readJvmClass(c.write());
+
+    SECTION("header")
+    {
+        REQUIRE(i.name == "org/example/Foo");
+        REQUIRE(i.source_file == "Foo.java");
+    }
+
+    SECTION("references")
+    {
+        REQUIRE(i.references.count("org/example/Bar"));
+        REQUIRE(i.references.count("org/example/Baz"));
+        REQUIRE(i.references.count("org/example/Private"));
+        REQUIRE(i.references.count("java/util/List"));
+        REQUIRE(i.references.count("java/lang/Object"));
+        REQUIRE(!i.references.count("org/example/Foo"));
+    }
+
+    SECTION("abi")
+    {
+        // private members and code do not matter
+        auto c2 = c;
+        c2.methods[1].descriptor = "()V";
+        c2.methods[0].code = "body3";
+        REQUIRE(readJvmClass(c2.write()).abi_hash == i.abi_hash);
+
+        // member order does not matter
+        auto c3 = c;
+        std::swap(c3.fields[0], c3.fields[1]);
+        REQUIRE(readJvmClass(c3.write()).abi_hash == i.abi_hash);
+
+        auto c4 = c;
+        c4.methods[0].descriptor = "()V";
+        REQUIRE(readJvmClass(c4.write()).abi_hash != i.abi_hash);
+
+        auto c5 = c;
+        c5.methods[1].access = 0x0001;
+        REQUIRE(readJvmClass(c5.write()).abi_hash != i.abi_hash);
+
+        // code is a part of abi when requested
+        REQUIRE(readJvmClass(c2.write(), true).abi_hash != readJvmClass(c.write(), true).abi_hash);
+    }
+
+    SECTION("constants")
+    {
+        auto c2 = c;
+        c2.fields[1].constant = 6;
+        auto i2 = readJvmClass(c2.write());
+        REQUIRE(i2.abi_hash == i.abi_hash);
+        REQUIRE(i2.constants_hash != i.constants_hash);
+    }
+
+    SECTION("errors")
+    {
+        REQUIRE_THROWS(readJvmClass(String("\xCA\xFE\xBA\xBE", 4)));
+        REQUIRE_THROWS(readJvmClass(String("abcd")));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
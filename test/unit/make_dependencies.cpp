@@ -0,0 +1,76 @@
+#include <make_dependencies.h>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+static Strings read(const String &s)
+{
+    Strings r;
+    for (auto &f : readMakeDependencies(s))
+        r.push_back(f.u8string());
+    return r;
+}
+
+TEST_CASE("Checking make dependencies", "[make_dependencies]")
+{
+    SECTION("gcc")
+    {
+        // g++ -MD -c src/main.cpp -o main.o
+        auto d = "main.o: src/main.cpp /usr/include/stdc-predef.h src/main.h \\\n"
+            " /usr/include/c++/12/vector \\\n"
+            " /usr/include/c++/12/bits/stl_vector.h\n";
+        REQUIRE(read(d) == Strings{ "src/main.cpp", "/usr/include/stdc-predef.h", "src/main.h",
+            "/usr/include/c++/12/vector", "/usr/include/c++/12/bits/stl_vector.h" });
+
+        // -MP adds empty rules for headers
+        auto mp = "main.o: src/main.cpp src/main.h\n\nsrc/main.h:\n";
+        REQUIRE(read(mp) == Strings{ "src/main.cpp", "src/main.h" });
+
+        // escaped spaces
+        auto sp = "a.o: dir\\ with\\ spaces/a.c b.h\n";
+        REQUIRE(read(sp) == Strings{ "dir with spaces/a.c", "b.h" });
+    }
+
+    SECTION("crlf")
+    {
+        auto d = "main.o: src/main.cpp \\\r\n src/main.h \\\r\n src/other.h\r\n\r\nsrc/main.h:\r\n";
+        REQUIRE(read(d) == Strings{ "src/main.cpp", "src/main.h", "src/other.h" });
+    }
+
+    SECTION("windows")
+    {
+        // clang on windows
+        auto d = "C:/build/obj/main.obj: C:/src/main.cpp C:/src/main.h \\\n"
+            "  C:/Program\\ Files/include/vector\n";
+        REQUIRE(read(d) == Strings{ "C:/src/main.cpp", "C:/src/main.h", "C:/Program Files/include/vector" });
+    }
+
+    SECTION("rustc")
+    {
+        // rustc --emit=dep-info,metadata,link
+        auto d = "/build/libfoo.rlib: src/lib.rs src/a.rs src/b/mod.rs\n"
+            "\n"
+            "/build/libfoo.rmeta: src/lib.rs src/a.rs src/b/mod.rs\n"
+            "\n"
+            "src/lib.rs:\n"
+            "src/a.rs:\n"
+            "src/b/mod.rs:\n";
+        REQUIRE(read(d) == Strings{ "src/lib.rs", "src/a.rs", "src/b/mod.rs" });
+    }
+
+    SECTION("empty")
+    {
+        REQUIRE(read("").empty());
+        REQUIRE(read("a.o:\n").empty());
+        REQUIRE(read("a.o: a.c").size() == 1);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <module_dependencies.h>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+// scans of test/build/cpp/modules
+
+// g++-14 -std=c++20 -fmodules-ts -E -fdeps-format=p1689r5 -fdeps-file=math.cpp.o.ddi -fdeps-target=math.cpp.o math.cpp
+static const String gcc_interface = R"({
+"rules": [
+{
+"primary-output": "math.cpp.o",
+"provides": [
+{
+"logical-name": "math",
+"is-interface": true
+}
+],
+"requires": [
+]
+}
+],
+"version": 0,
+"revision": 0
+}
+)";
+
+static const String gcc_implementation = R"({
+"rules": [
+{
+"primary-output": "math_impl.cpp.o",
+"requires": [
+{
+"logical-name": "math"
+}
+]
+}
+],
+"version": 0,
+"revision": 0
+}
+)";
+
+static const String gcc_importer = R"({
+"rules": [
+{
+"primary-output": "main.cpp.o",
+"requires": [
+{
+"logical-name": "math"
+},
+{
+"logical-name": "<vector>",
+"lookup-method": "include-angle",
+"source-path": "/usr/include/c++/14/vector"
+}
+]
+}
+],
+"version": 0,
+"revision": 0
+}
+)";
+
+// clang-scan-deps-18 -format=p1689 -- clang++-18 -std=c++20 -c math.cpp -o math.cpp.o
+static const String clang_partition = R"({
+  "revision": 0,
+  "rules": [
+    {
+      "primary-output": "math.cpp.o",
+      "provides": [
+        {
+          "is-interface": true,
+          "logical-name": "math:detail",
+          "source-path": "/src/math.cpp"
+        }
+      ],
+      "requires": [
+        {
+          "logical-name": "math:base"
+        }
+      ]
+    }
+  ],
+  "version": 1
+}
+)";
+
+static const String clang_importer = R"({
+  "revision": 0,
+  "rules": [
+    {
+      "primary-output": "main.cpp.o",
+      "requires": [
+        {
+          "logical-name": "math"
+        },
+        {
+          "logical-name": "std"
+        }
+      ]
+    }
+  ],
+  "version": 1
+}
+)";
+
+// no modules at all
+static const String clang_plain = R"({
+  "revision": 0,
+  "rules": [
+    {
+      "primary-output": "plain.cpp.o"
+    }
+  ],
+  "version": 1
+}
+)";
+
+TEST_CASE("Checking P1689 module dependencies", "[modules]")
+{
+    SECTION("gcc")
+    {
+        auto i = readModuleDependencies(gcc_interface);
+        REQUIRE(i.provides == "math");
+        REQUIRE(i.imports.empty());
+
+        auto m = readModuleDependencies(gcc_implementation);
+        REQUIRE(m.provides.empty());
+        REQUIRE(m.imports == StringSet{ "math" });
+
+        // header units are skipped
+        auto u = readModuleDependencies(gcc_importer);
+        REQUIRE(u.provides.empty());
+        REQUIRE(u.imports == StringSet{ "math" });
+    }
+
+    SECTION("clang")
+    {
+        auto p = readModuleDependencies(clang_partition);
+        REQUIRE(p.provides == "math:detail");
+        REQUIRE(p.imports == StringSet{ "math:base" });
+
+        auto u = readModuleDependencies(clang_importer);
+        REQUIRE(u.provides.empty());
+        REQUIRE(u.imports == StringSet{ "math", "std" });
+
+        auto n = readModuleDependencies(clang_plain);
+        REQUIRE(n.provides.empty());
+        REQUIRE(n.imports.empty());
+    }
+
+    SECTION("malformed")
+    {
+        REQUIRE_THROWS(readModuleDependencies(String{}));
+        REQUIRE_THROWS(readModuleDependencies(String{ "{" }));
+        REQUIRE_THROWS(readModuleDependencies(String{ R"({"version": 1})" }));
+        REQUIRE_THROWS(readModuleDependencies(String{ R"({"rules": [{"provides": [{"logical-name": "a"}, {"logical-name": "b"}]}]})" }));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <ninja_emitter.h>
+
+#include <sw/builder/sw_context.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+enum class DepFile
+{
+    None,
+    Separate,   // -MF file
+    Joined,     // -MFfile
+};
+
+// compile commands that differ only in files
+static std::shared_ptr<builder::Command> make_compile(const SwBuilderContext &swctx, const path &dir, int i, DepFile df)
+{
+    auto n = "f" + std::to_string(i);
+    auto src = dir / "src" / (n + ".cpp");
+    auto obj = dir / "obj" / (n + ".o");
+    auto d = dir / "obj" / (n + ".d");
+
+    auto c = std::make_shared<builder::Command>(swctx);
+    c->setProgram("/usr/bin/g++");
+    for (auto a : { "-O2", "-g", "-std=c++17", "-Wall", "-DNDEBUG" })
+        c->push_back(a);
+    // usual amount of dependencies
+    for (int j = 0; j < 40; j++)
+        c->push_back("-I" + normalize_path(dir / "pkg" / ("dep" + std::to_string(j)) / "include"));
+    for (int j = 0; j < 20; j++)
+        c->push_back("-DDEP" + std::to_string(j) + "_API=");
+    switch (df)
+    {
+    case DepFile::Separate:
+        c->push_back("-MMD");
+        c->push_back("-MF");
+        c->push_back(normalize_path(d));
+        break;
+    case DepFile::Joined:
+        c->push_back("-MMD");
+        c->push_back("-MF" + normalize_path(d));
+        break;
+    }
+    c->push_back("-c");
+    c->push_back(normalize_path(src));
+    c->push_back("-o");
+    c->push_back(normalize_path(obj));
+    c->addInput(src);
+    c->addOutput(obj);
+    return c;
+}
+
+struct NinjaFile
+{
+    String text;
+    size_t rules = 0;
+    size_t edges = 0;
+    Strings depfiles;
+
+    NinjaFile(const path &dir)
+    {
+        text = read_file(dir / NinjaEmitter::build_fn);
+        std::istringstream ss(text);
+        String line;
+        while (std::getline(ss, line))
+        {
+            if (line.find("rule ") == 0)
+                rules++;
+            else if (line.find("build ") == 0)
+                edges++;
+            else if (line.find("  depfile = ") == 0 && line != "  depfile = $depfile")
+                depfiles.push_back(line.substr(strlen("  depfile = ")));
+        }
+    }
+};
+
+static NinjaFile emit(const std::vector<std::shared_ptr<builder::Command>> &cmds, const path &dir)
+{
+    ExecutionPlan::VecT v;
+    for (auto &c : cmds)
+        v.push_back(c.get());
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    NinjaEmitter e(v, dir, false);
+    return NinjaFile(dir);
+}
+
+TEST_CASE("Checking ninja emitter", "[ninja]")
+{
+    auto dir = fs::temp_directory_path() / "sw_test_ninja";
+    SwBuilderContext swctx(dir / "storage");
+    auto gdir = dir / "g";
+    const int n = 100;
+
+    SECTION("rules are shared")
+    {
+        for (auto df : { DepFile::None, DepFile::Separate, DepFile::Joined })
+        {
+            std::vector<std::shared_ptr<builder::Command>> cmds;
+            for (int i = 0; i < n; i++)
+                cmds.push_back(make_compile(swctx, dir, i, df));
+            auto f = emit(cmds, gdir);
+            REQUIRE(f.rules == 1);
+            REQUIRE(f.edges == n);
+        }
+
+        // different flags make a different rule
+        std::vector<std::shared_ptr<builder::Command>> cmds;
+        for (int i = 0; i < n; i++)
+        {
+            cmds.push_back(make_compile(swctx, dir, i, DepFile::None));
+            if (i % 2)
+                cmds.back()->push_back("-fPIC");
+        }
+        auto f = emit(cmds, gdir);
+        REQUIRE(f.rules == 2);
+        REQUIRE(f.edges == n);
+    }
+
+    SECTION("depfiles")
+    {
+        for (auto df : { DepFile::Separate, DepFile::Joined })
+        {
+            std::vector<std::shared_ptr<builder::Command>> cmds;
+            for (int i = 0; i < n; i++)
+                cmds.push_back(make_compile(swctx, dir, i, df));
+            auto f = emit(cmds, gdir);
+            REQUIRE(f.text.find("  deps = gcc\n") != f.text.npos);
+            REQUIRE(f.depfiles.size() == n);
+            for (int i = 0; i < n; i++)
+            {
+                auto d = normalize_path(dir / "obj" / ("f" + std::to_string(i) + ".d"));
+                boost::replace_all(d, ":", "$:");
+                REQUIRE(f.depfiles[i] == d);
+            }
+        }
+
+        std::vector<std::shared_ptr<builder::Command>> cmds;
+        cmds.push_back(make_compile(swctx, dir, 0, DepFile::None));
+        auto f = emit(cmds, gdir);
+        REQUIRE(f.text.find("deps = gcc") == f.text.npos);
+        REQUIRE(f.depfiles.empty());
+    }
+}
+
+// run with: test.unit.ninja [.benchmark]
+TEST_CASE("Benchmarking ninja emitter", "[.benchmark]")
+{
+    auto dir = fs::temp_directory_path() / "sw_test_ninja";
+    SwBuilderContext swctx(dir / "storage");
+    const int n = 50000;
+
+    std::vector<std::shared_ptr<builder::Command>> cmds;
+    size_t command_lines_size = 0;
+    for (int i = 0; i < n; i++)
+    {
+        cmds.push_back(make_compile(swctx, dir, i, i % 2 ? DepFile::Separate : DepFile::Joined));
+        for (auto &a : cmds.back()->arguments)
+            command_lines_size += a->toString().size() + 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto f = emit(cmds, dir / "g");
+    auto t = std::chrono::high_resolution_clock::now() - start;
+
+    // one rule per depfile form
+    REQUIRE(f.rules == 2);
+    REQUIRE(f.edges == n);
+    // per edge text is files and variables only
+    REQUIRE(f.text.size() < command_lines_size / 2);
+
+    std::cout << n << " commands: " << std::chrono::duration_cast<std::chrono::milliseconds>(t).count() << " ms, "
+        << f.text.size() / n << " bytes per edge in build.ninja, "
+        << command_lines_size / n << " bytes per command line\n";
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
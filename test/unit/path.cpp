@@ -49,6 +49,27 @@ TEST_CASE("Checking Paths", "[path]")
         REQUIRE((p3 < p2));
         REQUIRE_FALSE((p2 < p3)); // namespace! org < com
     }
+
+    SECTION("Interned PackagePath")
+    {
+        PackagePath p1("com.ibm");
+        PackagePath p2("CoM.IBM");
+        PackagePath p3("org.IBM");
+        REQUIRE(p1.getId() == p2.getId());
+        REQUIRE(p1.getId() != p3.getId());
+        REQUIRE(p1.hash() == p2.hash());
+        REQUIRE(std::hash<PackagePath>()(p1) == std::hash<PackagePath>()(p2));
+
+        // ids must follow modifications
+        auto p4 = p1 / "Something";
+        REQUIRE(p4 == PackagePath("com.ibm.something"));
+        REQUIRE(p4.parent() == p2);
+        p4 /= "x";
+        REQUIRE(p4.toStringLower() == "com.ibm.something.x");
+        REQUIRE(p4.back(p1) == PackagePath("something.x"));
+        p4.clear();
+        REQUIRE(p4 == PackagePath());
+    }
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,88 @@
+#include <sw/builder/spawn.h>
+
+#include <chrono>
+#include <iostream>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+static primitives::Command make_command(const Strings &args)
+{
+    primitives::Command c;
+    c.setProgram(args[0]);
+    for (auto i = args.begin() + 1; i != args.end(); i++)
+        c.push_back(*i);
+    return c;
+}
+
+TEST_CASE("Checking process spawn", "[spawn]")
+{
+    auto c = make_command({ "/bin/sh", "-c", "echo out $SW_SPAWN_TEST; pwd; echo err >&2; exit 3" });
+    if (!canSpawnProcess(c))
+        return;
+
+    c.environment["SW_SPAWN_TEST"] = "x";
+    c.working_directory = fs::temp_directory_path();
+    std::error_code ec;
+    spawnProcess(c, "/bin/sh", ec);
+    REQUIRE(ec);
+    REQUIRE(c.exit_code);
+    REQUIRE(c.exit_code.value() == 3);
+    REQUIRE(c.out.text == "out x\n" + fs::canonical(c.working_directory).string() + "\n");
+    REQUIRE(c.err.text == "err\n");
+
+    auto c2 = make_command({ "/bin/true" });
+    std::error_code ec2;
+    spawnProcess(c2, "/bin/true", ec2);
+    REQUIRE(!ec2);
+    REQUIRE(c2.exit_code.value() == 0);
+
+    auto c3 = make_command({ "/nonexistent" });
+    std::error_code ec3;
+    spawnProcess(c3, "/nonexistent", ec3);
+    REQUIRE(ec3);
+}
+
+// run with: test.unit.spawn [.benchmark]
+TEST_CASE("Benchmarking process spawn", "[.benchmark]")
+{
+    const int n = 1000;
+
+    auto measure = [](auto &&f)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < n; i++)
+            f();
+        auto t = std::chrono::high_resolution_clock::now() - start;
+        return std::chrono::duration_cast<std::chrono::microseconds>(t).count() / n;
+    };
+
+    auto primitives_us = measure([]
+    {
+        auto c = make_command({ "/bin/true" });
+        std::error_code ec;
+        c.execute(ec);
+        REQUIRE(!ec);
+    });
+    std::cout << "primitives::Command: " << primitives_us << " us per command\n";
+
+    if (!canSpawnProcess(make_command({ "/bin/true" })))
+        return;
+    auto spawn_us = measure([]
+    {
+        auto c = make_command({ "/bin/true" });
+        std::error_code ec;
+        spawnProcess(c, "/bin/true", ec);
+        REQUIRE(!ec);
+    });
+    std::cout << "posix_spawn: " << spawn_us << " us per command\n";
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
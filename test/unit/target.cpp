@@ -0,0 +1,244 @@
+#include <target.h>
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <unordered_set>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+using namespace sw;
+
+// synthetic configurations: os x library type x configuration x compiler
+static std::vector<TargetSettings> make_configs()
+{
+    std::vector<TargetSettings> cfgs;
+    for (auto arch : { "x86", "x86_64", "arm", "aarch64" })
+    for (auto lib : { "shared", "static" })
+    for (auto cfg : { "debug", "release", "minimalsizerelease", "releasewithdebuginformation" })
+    for (auto c : { "msvc", "clang", "gcc" })
+    {
+        TargetSettings s;
+        s["os"]["kernel"] = "org.torvalds.linux";
+        s["os"]["arch"] = arch;
+        s["native"]["library"] = lib;
+        s["native"]["configuration"] = cfg;
+        s["native"]["program"]["cpp"] = String("com.") + c + ".compiler";
+        cfgs.push_back(s);
+    }
+    return cfgs;
+}
+
+static TargetContainer make_container(const std::vector<TargetSettings> &cfgs)
+{
+    TargetContainer c;
+    for (auto &s : cfgs)
+        c.push_back(std::make_shared<PredefinedTarget>(PackageId("org.sw.demo.x-1.0.0"), s));
+    return c;
+}
+
+TEST_CASE("Checking TargetContainer", "[target]")
+{
+    auto cfgs = make_configs();
+    auto c = make_container(cfgs);
+    REQUIRE(std::distance(c.begin(), c.end()) == cfgs.size());
+
+    SECTION("findEqual")
+    {
+        for (size_t i = 0; i < cfgs.size(); i++)
+            REQUIRE(std::distance(c.begin(), c.findEqual(cfgs[i])) == i);
+
+        auto s = cfgs[0];
+        s["native"]["library"] = "unknown";
+        REQUIRE(c.findEqual(s) == c.end());
+
+        // empty values do not take part in comparison
+        s = cfgs[3];
+        s["native"]["x"];
+        REQUIRE(std::distance(c.begin(), c.findEqual(s)) == 3);
+
+        // same settings replace target
+        auto t = std::make_shared<PredefinedTarget>(PackageId("org.sw.demo.x-1.0.0"), cfgs[5]);
+        c.push_back(t);
+        REQUIRE(std::distance(c.begin(), c.end()) == cfgs.size());
+        REQUIRE(c.findEqual(cfgs[5])->get() == t.get());
+    }
+
+    SECTION("findSuitable")
+    {
+        // more settings than target has
+        for (size_t i = 0; i < cfgs.size(); i++)
+        {
+            auto s = cfgs[i];
+            s["native"]["stdlib"]["cpp"] = "com.Microsoft.VisualStudio.VC.libcpp";
+            s["dry-run"] = "false";
+            REQUIRE(std::distance(c.begin(), c.findSuitable(s)) == i);
+        }
+
+        auto s = cfgs[7];
+        s["os"]["arch"] = "mips";
+        REQUIRE(c.findSuitable(s) == c.end());
+
+        // ignored values match anything
+        s["os"]["arch"].ignoreInComparison(true);
+        REQUIRE(std::distance(c.begin(), c.findSuitable(s)) == 7);
+
+        // missing value
+        s = cfgs[7];
+        s["native"].getSettings().erase("library");
+        REQUIRE(c.findSuitable(s) == c.end());
+    }
+
+    SECTION("ignored in comparison")
+    {
+        auto cfgs2 = cfgs;
+        for (auto &s : cfgs2)
+        {
+            s["name"] = "x";
+            s["name"].ignoreInComparison(true);
+        }
+        auto c2 = make_container(cfgs2);
+        for (size_t i = 0; i < cfgs.size(); i++)
+        {
+            REQUIRE(std::distance(c2.begin(), c2.findEqual(cfgs[i])) == i);
+            REQUIRE(std::distance(c2.begin(), c2.findSuitable(cfgs[i])) == i);
+        }
+    }
+}
+
+TEST_CASE("Checking FrozenTargetSettings", "[settings]")
+{
+    auto cfgs = make_configs();
+
+    SECTION("hash-consing")
+    {
+        FrozenTargetSettings f1 = cfgs[0];
+        auto s = cfgs[0];
+        FrozenTargetSettings f2 = s;
+        REQUIRE(&f1.get() == &f2.get());
+        REQUIRE(f1 == f2);
+        REQUIRE(f1.getId() == f2.getId());
+        REQUIRE_FALSE(f1 < f2);
+        REQUIRE_FALSE(f2 < f1);
+
+        // source changes do not affect frozen settings
+        s["native"]["library"] = "unknown";
+        REQUIRE(f2.get() == cfgs[0]);
+        FrozenTargetSettings f3 = s;
+        REQUIRE(f3 != f1);
+        REQUIRE(f3.get() == s);
+
+        // use counter is not a part of identity
+        s = cfgs[0];
+        s["native"]["library"].setUseCount(5);
+        REQUIRE(FrozenTargetSettings(s) == f1);
+
+        FrozenTargetSettings e;
+        REQUIRE(e.get().empty());
+        REQUIRE(e == FrozenTargetSettings(TargetSettings{}));
+    }
+
+    SECTION("equality")
+    {
+        std::vector<FrozenTargetSettings> frozen(cfgs.begin(), cfgs.end());
+        for (size_t i = 0; i < cfgs.size(); i++)
+        {
+            for (size_t j = 0; j < cfgs.size(); j++)
+                REQUIRE((frozen[i] == frozen[j]) == (i == j));
+        }
+
+        // flags make trees different, even when settings compare equal
+        auto s = cfgs[1];
+        s["native"]["configuration"].ignoreInComparison(true);
+        REQUIRE(s == cfgs[1]);
+        REQUIRE(FrozenTargetSettings(s) != frozen[1]);
+        s["native"]["configuration"].ignoreInComparison(false);
+        REQUIRE(FrozenTargetSettings(s) == frozen[1]);
+
+        // ordering is strict and stable
+        std::set<FrozenTargetSettings> set(frozen.begin(), frozen.end());
+        REQUIRE(set.size() == cfgs.size());
+        for (auto &f : frozen)
+            REQUIRE(set.find(f) != set.end());
+    }
+
+    SECTION("hash")
+    {
+        for (auto &s : cfgs)
+        {
+            FrozenTargetSettings f = s;
+            REQUIRE(f.getHash() == s.getHash());
+            REQUIRE(std::hash<FrozenTargetSettings>()(f) == std::hash<FrozenTargetSettings>()(FrozenTargetSettings(s)));
+        }
+
+        std::unordered_set<FrozenTargetSettings> set(cfgs.begin(), cfgs.end());
+        REQUIRE(set.size() == cfgs.size());
+        set.insert(cfgs[0]);
+        REQUIRE(set.size() == cfgs.size());
+    }
+
+    SECTION("lookups")
+    {
+        auto c = make_container(cfgs);
+        for (size_t i = 0; i < cfgs.size(); i++)
+        {
+            FrozenTargetSettings f = cfgs[i];
+            REQUIRE(std::distance(c.begin(), c.findEqual(f)) == i);
+            REQUIRE(std::distance(c.begin(), c.findSuitable(f)) == i);
+            // memoized
+            REQUIRE(std::distance(c.begin(), c.findSuitable(f)) == i);
+        }
+
+        // memo is dropped when targets change
+        auto s = cfgs[0];
+        s["native"]["library"] = "unknown";
+        FrozenTargetSettings f = s;
+        REQUIRE(c.findEqual(f) == c.end());
+        c.push_back(std::make_shared<PredefinedTarget>(PackageId("org.sw.demo.x-1.0.0"), s));
+        REQUIRE(std::distance(c.begin(), c.findEqual(f)) == cfgs.size());
+    }
+}
+
+// run with: test.unit.target [.benchmark]
+TEST_CASE("Benchmarking TargetContainer", "[.benchmark]")
+{
+    auto cfgs = make_configs();
+    const int n_packages = 200;
+    const int n_deps = 10;
+
+    std::vector<TargetContainer> packages;
+    for (int i = 0; i < n_packages; i++)
+        packages.push_back(make_container(cfgs));
+
+    // every target of every package looks up its dependencies with the same settings
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t found = 0;
+    for (int i = 0; i < n_packages; i++)
+    {
+        for (auto &s : cfgs)
+        {
+            for (int d = 1; d <= n_deps; d++)
+            {
+                auto &dep = packages[(i + d) % n_packages];
+                if (dep.findSuitable(s) != dep.end())
+                    found++;
+                if (dep.findEqual(s) != dep.end())
+                    found++;
+            }
+        }
+    }
+    auto t = std::chrono::high_resolution_clock::now() - start;
+    REQUIRE(found == 2 * n_packages * cfgs.size() * n_deps);
+
+    std::cout << n_packages * cfgs.size() * n_deps << " dependency edges, "
+        << cfgs.size() << " configurations per package: "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(t).count() << " ms\n";
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}
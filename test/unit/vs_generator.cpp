@@ -0,0 +1,85 @@
+#include <sw/builder/command.h>
+#include <sw/support/filesystem.h>
+
+#include <algorithm>
+#include <map>
+
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+// generates test/build/cpp/static with sw from PATH (or SW_EXECUTABLE)
+
+static path get_sw()
+{
+    if (auto e = getenv("SW_EXECUTABLE"))
+        return e;
+    return "sw";
+}
+
+static void generate(const path &dir)
+{
+    primitives::Command c;
+    c.working_directory = dir;
+    c.setProgram(get_sw().is_absolute() ? get_sw() : primitives::resolve_executable(get_sw()));
+    c.push_back("generate");
+    c.push_back("-g");
+    c.push_back("vs");
+    std::error_code ec;
+    c.execute(ec);
+    INFO(c.out.text + c.err.text);
+    REQUIRE(c.exit_code);
+    REQUIRE(c.exit_code.value() == 0);
+}
+
+struct SolutionFiles
+{
+    std::map<path, String> contents;
+    std::map<path, fs::file_time_type> times;
+
+    SolutionFiles(const path &dir)
+    {
+        // files that make IDE reload solution or projects
+        for (auto &f : fs::recursive_directory_iterator(dir / SW_BINARY_DIR / "g"))
+        {
+            auto e = f.path().extension();
+            if (!fs::is_regular_file(f) || (e != ".sln" && e != ".vcxproj" && e != ".filters"))
+                continue;
+            contents[f.path()] = read_file(f);
+            times[f.path()] = fs::last_write_time(f);
+        }
+    }
+};
+
+// run with: test.unit.vs_generator [.vs]
+TEST_CASE("Checking vs generator", "[.vs]")
+{
+#ifndef _WIN32
+    return;
+#endif
+
+    auto src = path(__FILE__).parent_path().parent_path() / "build" / "cpp" / "static";
+    auto dir = fs::temp_directory_path() / "sw_test_vs_generator";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::copy(src, dir, fs::copy_options::recursive);
+
+    generate(dir);
+    SolutionFiles f1(dir);
+    // solution + 4 projects
+    REQUIRE(std::count_if(f1.contents.begin(), f1.contents.end(), [](auto &p) { return p.first.extension() == ".sln"; }) == 1);
+    REQUIRE(std::count_if(f1.contents.begin(), f1.contents.end(), [](auto &p) { return p.first.extension() == ".vcxproj"; }) >= 4);
+
+    // projects are emitted in parallel, output must not depend on it
+    generate(dir);
+    SolutionFiles f2(dir);
+    REQUIRE(f1.contents == f2.contents);
+    // unchanged files are not rewritten
+    REQUIRE(f1.times == f2.times);
+}
+
+int main(int argc, char **argv)
+{
+    Catch::Session().run(argc, argv);
+
+    return 0;
+}